@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <functional>
+#include <utils/flog.h>
+#include <dsp/bench/speed_tester.h>
+#include <dsp/chain.h>
+#include <dsp/filter/fir.h>
+#include <dsp/filter/decimating_fir.h>
+#include <dsp/filter/deephasis.h>
+#include <dsp/taps/low_pass.h>
+#include <dsp/multirate/power_decimator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/demod/fm.h>
+#include <dsp/demod/am.h>
+#include <dsp/demod/ssb.h>
+#include <dsp/loop/agc.h>
+#include <dsp/loop/fast_agc.h>
+#include <dsp/loop/pll.h>
+#include <dsp/loop/costas.h>
+#include <dsp/loop/carrier_tracking_pll.h>
+#include <dsp/noise_reduction/fm_if.h>
+#include <dsp/noise_reduction/noise_blanker.h>
+#include <dsp/noise_reduction/squelch.h>
+#include <dsp/correction/dc_blocker.h>
+#include <dsp/math/conjugate.h>
+#include <dsp/convert/complex_to_real.h>
+#include <dsp/convert/stereo_to_mono.h>
+#include <dsp/compression/sample_stream_compressor.h>
+
+// Each case pushes random samples through one block or chain for a fixed time and prints one CSV line:
+//   name,in_msps,ns_per_sample,out_msps
+// ns_per_sample is relative to input samples so that cases can be compared between runs.
+
+struct Options {
+    int durationMs = 1000;
+    int warmupMs = 200;
+    int bufferSize = 32768;
+    std::vector<std::string> filters;
+    bool list = false;
+};
+
+static Options opts;
+
+static bool selected(const std::string& name) {
+    if (opts.list) {
+        printf("%s\n", name.c_str());
+        return false;
+    }
+    if (opts.filters.empty()) { return true; }
+    for (const auto& f : opts.filters) {
+        if (name.find(f) != std::string::npos) { return true; }
+    }
+    return false;
+}
+
+template <class I, class O>
+static void measure(const std::string& name, dsp::stream<I>* in, dsp::stream<O>* out, std::function<void()> start, std::function<void()> stop) {
+    start();
+    dsp::bench::SpeedTester<I, O> tester(in, out);
+    double rate = tester.benchmark(opts.durationMs, opts.bufferSize, opts.warmupMs);
+    stop();
+    printf("%s,%.3f,%.3f,%.3f\n", name.c_str(), rate * 1e-6, (rate > 0.0) ? (1e9 / rate) : 0.0, tester.getOutputRate() * 1e-6);
+    fflush(stdout);
+}
+
+template <class I, class O>
+static void measure(const std::string& name, dsp::stream<I>* in, dsp::Processor<I, O>& block) {
+    measure<I, O>(name, in, &block.out, [&]() { block.start(); }, [&]() { block.stop(); });
+}
+
+template <class T>
+static void measure(const std::string& name, dsp::stream<T>* in, dsp::chain<T>& chain) {
+    measure<T, T>(name, in, chain.out, [&]() { chain.start(); }, [&]() { chain.stop(); });
+}
+
+static void benchFilters() {
+    for (int tapCount : { 32, 128, 512, 2048 }) {
+        // Automatic selection, then each convolution method on its own
+        struct ModeCase { const char* suffix; dsp::filter::ConvolutionMode mode; };
+        for (auto& mc : { ModeCase{ "", dsp::filter::CONVOLUTION_AUTO }, ModeCase{ "_direct", dsp::filter::CONVOLUTION_DIRECT }, ModeCase{ "_fft", dsp::filter::CONVOLUTION_FFT } }) {
+            std::string name = "filter/fir_c" + std::to_string(tapCount) + mc.suffix;
+            if (!selected(name)) { continue; }
+            dsp::stream<dsp::complex_t> in;
+            auto taps = dsp::taps::alloc<float>(tapCount);
+            for (int i = 0; i < tapCount; i++) { taps.taps[i] = 1.0f / (float)tapCount; }
+            dsp::filter::FIR<dsp::complex_t, float> fir(&in, taps);
+            fir.setConvolutionMode(mc.mode);
+            measure(name, &in, fir);
+            dsp::taps::free(taps);
+        }
+
+        std::string name = "filter/fir_f" + std::to_string(tapCount);
+        if (selected(name)) {
+            dsp::stream<float> in;
+            auto taps = dsp::taps::alloc<float>(tapCount);
+            for (int i = 0; i < tapCount; i++) { taps.taps[i] = 1.0f / (float)tapCount; }
+            dsp::filter::FIR<float, float> fir(&in, taps);
+            measure(name, &in, fir);
+            dsp::taps::free(taps);
+        }
+    }
+
+    for (int decim : { 2, 4, 10 }) {
+        std::string name = "filter/decimating_fir_c_d" + std::to_string(decim);
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        auto taps = dsp::taps::lowPass(0.4 / decim, 0.1 / decim, 1.0);
+        dsp::filter::DecimatingFIR<dsp::complex_t, float> fir(&in, taps, decim);
+        measure(name, &in, fir);
+        dsp::taps::free(taps);
+    }
+
+    if (selected("filter/decimating_fir_c_halfband")) {
+        // A cutoff of a quarter of the samplerate with an odd tap count gives a half-band filter
+        dsp::stream<dsp::complex_t> in;
+        auto taps = dsp::taps::lowPass(0.25, 0.05, 1.0, true);
+        dsp::filter::DecimatingFIR<dsp::complex_t, float> fir(&in, taps, 2);
+        measure("filter/decimating_fir_c_halfband", &in, fir);
+        dsp::taps::free(taps);
+    }
+
+    if (selected("filter/deemphasis_s")) {
+        dsp::stream<dsp::stereo_t> in;
+        dsp::filter::Deemphasis<dsp::stereo_t> deemp;
+        deemp.init(&in, 50e-6, 48000.0);
+        measure("filter/deemphasis_s", &in, deemp);
+    }
+}
+
+static void benchMultirate() {
+    // One case per decimation plan
+    for (unsigned int ratio = 2; ratio <= dsp::multirate::PowerDecimator<dsp::complex_t>::getMaxRatio(); ratio <<= 1) {
+        std::string name = "multirate/power_decimator_c_r" + std::to_string(ratio);
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::multirate::PowerDecimator<dsp::complex_t> decim(&in, ratio);
+        measure(name, &in, decim);
+    }
+
+    struct ResampCase { const char* name; double inSr; double outSr; };
+    for (auto& rc : { ResampCase{ "2400k_250k", 2400000.0, 250000.0 }, ResampCase{ "250k_48k", 250000.0, 48000.0 }, ResampCase{ "48k_44k1", 48000.0, 44100.0 } }) {
+        std::string name = std::string("multirate/rational_resampler_c_") + rc.name;
+        if (selected(name)) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::multirate::RationalResampler<dsp::complex_t> resamp(&in, rc.inSr, rc.outSr);
+            measure(name, &in, resamp);
+        }
+
+        name = std::string("multirate/rational_resampler_s_") + rc.name;
+        if (selected(name)) {
+            dsp::stream<dsp::stereo_t> in;
+            dsp::multirate::RationalResampler<dsp::stereo_t> resamp(&in, rc.inSr, rc.outSr);
+            measure(name, &in, resamp);
+        }
+    }
+}
+
+static void benchChannel() {
+    if (selected("channel/frequency_xlator")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::channel::FrequencyXlator xlator(&in, 0.1234);
+        measure("channel/frequency_xlator", &in, xlator);
+    }
+
+    struct VFOCase { const char* name; double inSr; double outSr; double bw; };
+    for (auto& vc : { VFOCase{ "2400k_250k_wfm", 2400000.0, 250000.0, 200000.0 }, VFOCase{ "2400k_12k5_nfm", 2400000.0, 12500.0, 12500.0 }, VFOCase{ "20000k_250k_wfm", 20000000.0, 250000.0, 200000.0 } }) {
+        std::string name = std::string("channel/rx_vfo_") + vc.name;
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::channel::RxVFO vfo(&in, vc.inSr, vc.outSr, vc.bw, vc.inSr * 0.123);
+        measure(name, &in, vfo);
+    }
+}
+
+static void benchDemod() {
+    // Default arctangent accuracy, then the others
+    struct AccuracyCase { const char* suffix; dsp::math::Atan2Accuracy accuracy; };
+    for (auto& ac : { AccuracyCase{ "", dsp::math::ATAN2_ACCURACY_MEDIUM }, AccuracyCase{ "_low", dsp::math::ATAN2_ACCURACY_LOW }, AccuracyCase{ "_high", dsp::math::ATAN2_ACCURACY_HIGH }, AccuracyCase{ "_exact", dsp::math::ATAN2_ACCURACY_EXACT } }) {
+        std::string name = std::string("demod/quadrature") + ac.suffix;
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::Quadrature quad(&in, 75000.0, 250000.0);
+        quad.setAccuracy(ac.accuracy);
+        measure(name, &in, quad);
+    }
+
+    for (bool stereo : { false, true }) {
+        std::string name = stereo ? "demod/broadcast_fm_stereo" : "demod/broadcast_fm_mono";
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::BroadcastFM bfm(&in, 75000.0, 250000.0, stereo, true);
+        measure(name, &in, bfm);
+    }
+
+    if (selected("demod/fm_nfm")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::FM<dsp::stereo_t> fm;
+        fm.init(&in, 12500.0, 12500.0, true, false);
+        measure("demod/fm_nfm", &in, fm);
+    }
+
+    if (selected("demod/am")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::AM<dsp::stereo_t> am;
+        am.init(&in, dsp::demod::AM<dsp::stereo_t>::AGCMode::CARRIER, 10000.0, 50.0 / 24000.0, 5.0 / 24000.0, 100.0 / 24000.0, 24000.0);
+        measure("demod/am", &in, am);
+    }
+
+    if (selected("demod/ssb_usb")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::SSB<dsp::stereo_t> ssb;
+        ssb.init(&in, dsp::demod::SSB<dsp::stereo_t>::Mode::USB, 2800.0, 24000.0, true, 50.0 / 24000.0, 5.0 / 24000.0);
+        measure("demod/ssb_usb", &in, ssb);
+    }
+}
+
+static void benchLoops() {
+    if (selected("loop/agc_f")) {
+        dsp::stream<float> in;
+        dsp::loop::AGC<float> agc;
+        agc.init(&in, 1.0, 50.0 / 48000.0, 5.0 / 48000.0, 10e6, 10.0);
+        measure("loop/agc_f", &in, agc);
+    }
+
+    if (selected("loop/agc_c")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::AGC<dsp::complex_t> agc;
+        agc.init(&in, 1.0, 50.0 / 48000.0, 5.0 / 48000.0, 10e6, 10.0);
+        measure("loop/agc_c", &in, agc);
+    }
+
+    if (selected("loop/agc_f_fast_decay")) {
+        // Envelope falling much faster than it rises, noise peaks keep triggering the clipping look-ahead
+        dsp::stream<float> in;
+        dsp::loop::AGC<float> agc;
+        agc.init(&in, 1.0, 50.0 / 48000.0, 0.5, 10e6, 10.0);
+        measure("loop/agc_f_fast_decay", &in, agc);
+    }
+
+    if (selected("loop/pll")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::PLL pll(&in, 0.01);
+        measure("loop/pll", &in, pll);
+    }
+
+    if (selected("loop/carrier_tracking_pll")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::CarrierTrackingPLL pll(&in, 0.01);
+        measure("loop/carrier_tracking_pll", &in, pll);
+    }
+
+    if (selected("loop/costas_4")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::Costas<4> costas(&in, 0.01);
+        measure("loop/costas_4", &in, costas);
+    }
+
+    if (selected("loop/fast_agc_c")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::FastAGC<dsp::complex_t> agc(&in, 1.0, 10e6, 1e-3);
+        measure("loop/fast_agc_c", &in, agc);
+    }
+}
+
+static void benchMisc() {
+    // One full search per sample, then the hops of the normal and low quality settings of the radio
+    for (int hop : { 1, 4, 16 }) {
+        std::string name = "noise_reduction/fm_if_32" + ((hop > 1) ? ("_hop" + std::to_string(hop)) : std::string());
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::noise_reduction::FMIF fmif(&in, 32, hop);
+        measure(name, &in, fmif);
+    }
+
+    if (selected("noise_reduction/noise_blanker")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::noise_reduction::NoiseBlanker nb(&in, 500.0 / 24000.0, 10.0);
+        measure("noise_reduction/noise_blanker", &in, nb);
+    }
+
+    if (selected("noise_reduction/squelch")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::noise_reduction::Squelch squelch;
+        squelch.init(&in, -100.0);
+        measure("noise_reduction/squelch", &in, squelch);
+    }
+
+    if (selected("correction/dc_blocker_c")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::correction::DCBlocker<dsp::complex_t> dcBlock(&in, 50.0 / 2400000.0);
+        measure("correction/dc_blocker_c", &in, dcBlock);
+    }
+
+    if (selected("math/conjugate")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::math::Conjugate conj(&in);
+        measure("math/conjugate", &in, conj);
+    }
+
+    if (selected("convert/complex_to_real")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::convert::ComplexToReal c2r(&in);
+        measure("convert/complex_to_real", &in, c2r);
+    }
+
+    if (selected("convert/stereo_to_mono")) {
+        dsp::stream<dsp::stereo_t> in;
+        dsp::convert::StereoToMono s2m(&in);
+        measure("convert/stereo_to_mono", &in, s2m);
+    }
+
+    if (selected("compression/sample_stream_compressor_i8")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::compression::SampleStreamCompressor comp(&in, dsp::compression::PCM_TYPE_I8);
+        measure("compression/sample_stream_compressor_i8", &in, comp);
+    }
+}
+
+static void benchChains() {
+    // IQ front end pre-processing
+    if (selected("chain/iq_preproc_r4")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::multirate::PowerDecimator<dsp::complex_t> decim(NULL, 4);
+        dsp::correction::DCBlocker<dsp::complex_t> dcBlock(NULL, 50.0 / 600000.0);
+        dsp::chain<dsp::complex_t> chain(&in);
+        chain.addBlock(&decim, true);
+        chain.addBlock(&dcBlock, true);
+        measure("chain/iq_preproc_r4", &in, chain);
+    }
+
+    // Radio IF processing, with and without fusing
+    for (bool fused : { false, true }) {
+        std::string name = fused ? "chain/radio_if_fused" : "chain/radio_if";
+        if (!selected(name)) { continue; }
+        dsp::stream<dsp::complex_t> in;
+        dsp::noise_reduction::NoiseBlanker nb(NULL, 500.0 / 24000.0, 10.0);
+        dsp::noise_reduction::FMIF fmnr(NULL, 32);
+        dsp::noise_reduction::Squelch squelch;
+        squelch.init(NULL, -100.0);
+        dsp::chain<dsp::complex_t> chain(&in);
+        chain.addBlock(&nb, true);
+        chain.addBlock(&fmnr, true);
+        chain.addBlock(&squelch, true);
+        chain.setFused(fused, [](dsp::stream<dsp::complex_t>* out) {});
+        measure(name, &in, chain);
+    }
+
+    // Full wideband FM receive path
+    if (selected("chain/wfm_rx")) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::channel::RxVFO vfo(&in, 2400000.0, 250000.0, 200000.0, 300000.0);
+        dsp::demod::BroadcastFM bfm(&vfo.out, 75000.0, 250000.0, true, true);
+        dsp::multirate::RationalResampler<dsp::stereo_t> resamp(&bfm.out, 250000.0, 48000.0);
+        measure<dsp::complex_t, dsp::stereo_t>("chain/wfm_rx", &in, &resamp.out,
+            [&]() { vfo.start(); bfm.start(); resamp.start(); },
+            [&]() { resamp.stop(); bfm.stop(); vfo.stop(); });
+    }
+}
+
+static void showHelp() {
+    printf("Usage: sdrpp_bench [options] [filter...]\n");
+    printf("Runs every benchmark whose name contains one of the filters, or all of them.\n\n");
+    printf("  -d, --duration <ms>   Measurement time per case (default %d)\n", opts.durationMs);
+    printf("  -w, --warmup <ms>     Time before measuring (default %d)\n", opts.warmupMs);
+    printf("  -b, --buffer <size>   Samples per input buffer (default %d)\n", opts.bufferSize);
+    printf("  -l, --list            List the benchmark names\n");
+    printf("  -h, --help            Show this help\n");
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if ((arg == "-d" || arg == "--duration") && hasValue) {
+            opts.durationMs = atoi(argv[++i]);
+        }
+        else if ((arg == "-w" || arg == "--warmup") && hasValue) {
+            opts.warmupMs = atoi(argv[++i]);
+        }
+        else if ((arg == "-b" || arg == "--buffer") && hasValue) {
+            opts.bufferSize = std::clamp<int>(atoi(argv[++i]), 1, STREAM_BUFFER_SIZE);
+        }
+        else if (arg == "-l" || arg == "--list") {
+            opts.list = true;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            showHelp();
+            return 0;
+        }
+        else if (!arg.empty() && arg[0] != '-') {
+            opts.filters.push_back(arg);
+        }
+        else {
+            showHelp();
+            return -1;
+        }
+    }
+
+    if (!opts.list) { printf("name,in_msps,ns_per_sample,out_msps\n"); }
+
+    benchFilters();
+    benchMultirate();
+    benchChannel();
+    benchDemod();
+    benchLoops();
+    benchMisc();
+    benchChains();
+
+    return 0;
+}
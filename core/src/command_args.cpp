@@ -16,6 +16,7 @@ void CommandArgsParser::defineAll() {
         define('a', "addr", "Server mode address", "0.0.0.0");
         define('h', "help", "Show help");
         define('p', "port", "Server mode port", 5259);
+        define('\0', "profile", "Log DSP block statistics every N seconds, 0 to disable", 0);
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
         define('\0', "autostart", "Automatically start the SDR after loading");
@@ -20,6 +20,10 @@
 #include <stb_image_resize.h>
 #include <gui/gui.h>
 #include <signal_path/signal_path.h>
+#include <dsp/scheduler.h>
+#include <dsp/profiler.h>
+#include <dsp/buffer/buffer.h>
+#include <dsp/latency.h>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -240,8 +244,18 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["showWaterfall"] = true;
     defConfig["source"] = "";
     defConfig["decimationPower"] = 0;
+    defConfig["dspScheduler"]["enabled"] = false;
+    defConfig["dspScheduler"]["workerCount"] = 0; // One per core
+    defConfig["dspAdaptiveBuffers"] = true;
+    defConfig["latencyTracing"] = false;
+    defConfig["dspBufferPool"]["enabled"] = true;
+    defConfig["dspBufferPool"]["maxCachedMB"] = 256;
+    defConfig["dspBufferPool"]["hugePages"] = "off"; // "off", "transparent" or "explicit"
+    defConfig["threadPolicies"] = json::array(); // e.g. {"pattern": "dsp*", "cpus": [2, 3], "scheduling": "fifo", "priority": 50, "nice": -5}
     defConfig["iqCorrection"] = false;
     defConfig["invertIQ"] = false;
+    defConfig["channelizer"] = false;
+    defConfig["sharedDecimation"] = false;
 
     defConfig["streams"]["Radio"]["muted"] = false;
     defConfig["streams"]["Radio"]["sink"] = "Audio";
@@ -348,9 +362,50 @@ int sdrpp_main(int argc, char* argv[]) {
     // Load UI scaling
     style::uiScale = core::configManager.conf["uiScale"];
 
+    // Load the thread policies before the DSP threads get started
+    std::vector<threading::ThreadPolicy> threadPolicies;
+    for (auto& item : core::configManager.conf["threadPolicies"]) {
+        threading::ThreadPolicy pol;
+        pol.pattern = item.value("pattern", "*");
+        if (item.contains("cpus")) { pol.cpus = item["cpus"].get<std::vector<int>>(); }
+        std::string scheduling = item.value("scheduling", "default");
+        if (scheduling == "fifo") { pol.scheduling = threading::SCHEDULING_FIFO; }
+        else if (scheduling == "rr") { pol.scheduling = threading::SCHEDULING_RR; }
+        pol.priority = item.value("priority", 0);
+        pol.setNice = item.contains("nice");
+        pol.nice = item.value("nice", 0);
+        threadPolicies.push_back(pol);
+    }
+    threading::setThreadPolicies(threadPolicies);
+
+    // The DSP worker pool is started later, before any block gets started
+    bool schedEnabled = core::configManager.conf["dspScheduler"]["enabled"];
+    int schedWorkers = core::configManager.conf["dspScheduler"]["workerCount"];
+
+    // Size block outputs to what they actually produce instead of the default stream size
+    dsp::buffer::setAdaptiveStreams(core::configManager.conf["dspAdaptiveBuffers"]);
+
+    // Measure how long it takes for samples to go from the source to each stage of the signal path
+    dsp::latency::setEnabled(core::configManager.conf["latencyTracing"]);
+
+    // Configure the sample buffer pool, only buffers allocated from now on can use hugepages
+    std::string hugePages = core::configManager.conf["dspBufferPool"]["hugePages"];
+    dsp::buffer::setPoolEnabled(core::configManager.conf["dspBufferPool"]["enabled"]);
+    dsp::buffer::setPoolLimit((int64_t)core::configManager.conf["dspBufferPool"]["maxCachedMB"] * 1024 * 1024);
+    if (hugePages == "transparent") {
+        dsp::buffer::setHugePages(dsp::buffer::HUGE_PAGES_TRANSPARENT);
+    }
+    else if (hugePages == "explicit") {
+        dsp::buffer::setHugePages(dsp::buffer::HUGE_PAGES_EXPLICIT);
+    }
+
     core::configManager.release(true);
 
-    if (serverMode) { return server::main(); }
+    if (serverMode) {
+        if (schedEnabled) { dsp::scheduler::init(schedWorkers); }
+        dsp::profiler::startLogging((int)core::args["profile"]);
+        return server::main();
+    }
 
     core::configManager.acquire();
     std::string resDir = core::configManager.conf["resourcesDirectory"];
@@ -387,6 +442,12 @@ int sdrpp_main(int argc, char* argv[]) {
     flog::info("Loading band plans color table");
     bandplan::loadColorTable(bandColors);
 
+    // Only start the worker pool and stats logger once nothing can fail anymore, their threads must be joined before exiting
+    if (schedEnabled) { dsp::scheduler::init(schedWorkers); }
+
+    // Block statistics are always available in the debug menu, this also logs them
+    dsp::profiler::startLogging((int)core::args["profile"]);
+
     gui::mainWindow.init();
 
     flog::info("Ready.");
@@ -405,6 +466,8 @@ int sdrpp_main(int argc, char* argv[]) {
     backend::end();
 
     sigpath::iqFrontEnd.stop();
+    dsp::scheduler::stop();
+    dsp::profiler::stopLogging();
 
     core::configManager.disableAutoSave();
     core::configManager.save();
@@ -50,6 +50,8 @@ namespace dsp::audio {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         float _volume;
         bool _muted;
@@ -1,5 +1,7 @@
 #pragma once
 #include <thread>
+#include <atomic>
+#include <chrono>
 #include <assert.h>
 #include "../stream.h"
 #include "../types.h"
@@ -28,7 +30,9 @@ namespace dsp::bench {
             _out = out;
         }
 
-        double benchmark(int durationMs, int bufferSize) {
+        // Returns the input rate in samples per second. The first warmupMs aren't measured
+        // so that the result doesn't include the startup of the blocks under test.
+        double benchmark(int durationMs, int bufferSize, int warmupMs = 0) {
             assert(_init);
 
             // Allocate and fill buffer
@@ -39,6 +43,10 @@ namespace dsp::bench {
                     randBuf[i].re = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f;
                     randBuf[i].im = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f;
                 }
+                else if constexpr (std::is_same_v<I, stereo_t>) {
+                    randBuf[i].l = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f;
+                    randBuf[i].r = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f;
+                }
                 else if constexpr (std::is_same_v<I, float>) {
                     randBuf[i] = (2.0f * (float)rand() / (float)RAND_MAX) - 1.0f;
                 }
@@ -49,10 +57,24 @@ namespace dsp::bench {
 
             // Run test
             start();
+            if (warmupMs > 0) { std::this_thread::sleep_for(std::chrono::milliseconds(warmupMs)); }
+            auto t0 = std::chrono::steady_clock::now();
+            uint64_t in0 = sampCount;
+            uint64_t out0 = outSampCount;
             std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+            uint64_t in1 = sampCount;
+            uint64_t out1 = outSampCount;
+            double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
             stop();
             buffer::free(randBuf);
-            return (double)sampCount * 1000.0 / (double)durationMs;
+
+            outRate = (double)(out1 - out0) / secs;
+            return (double)(in1 - in0) / secs;
+        }
+
+        // Output rate in samples per second measured during the last benchmark
+        double getOutputRate() {
+            return outRate;
         }
 
     protected:
@@ -60,6 +82,7 @@ namespace dsp::bench {
             if (running) { return; }
             running = true;
             sampCount = 0;
+            outSampCount = 0;
             wthr = std::thread(&SpeedTester::writeWorker, this);
             rthr = std::thread(&SpeedTester::readWorker, this);
         }
@@ -88,6 +111,7 @@ namespace dsp::bench {
                 int count = _out->read();
                 _out->flush();
                 if (count < 0) { return; }
+                outSampCount += count;
             }
         }
 
@@ -99,7 +123,9 @@ namespace dsp::bench {
         I* randBuf;
         std::thread wthr;
         std::thread rthr;
-        uint64_t sampCount;
+        std::atomic<uint64_t> sampCount = 0;
+        std::atomic<uint64_t> outSampCount = 0;
+        double outRate = 0.0;
 
     };
 }
\ No newline at end of file
@@ -3,11 +3,17 @@
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <typeinfo>
 #include "stream.h"
 #include "types.h"
+#include "scheduler.h"
+#include "profiler.h"
 #include <utils/threading.h>
 
 namespace dsp {
+    template <class T>
+    class chain;
+
     class generic_block {
     public:
         virtual ~generic_block() {}
@@ -19,6 +25,7 @@ namespace dsp {
     class block : public generic_block {
     public:
         virtual ~block() {
+            if (profiled) { profiler::remove(this); }
             if (!_block_init) { return; }
             stop();
             _block_init = false;
@@ -66,12 +73,62 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Blocks whose run() does a single read per input and a single swap per output can be
+        // serviced by the scheduler's worker pool instead of their own thread
+        virtual bool schedulable() { return false; }
+
+        // True if a call to run() won't block
+        bool isReady() {
+            for (auto& in : inputs) {
+                if (!in->readable()) { return false; }
+            }
+            for (auto& out : outputs) {
+                if (!out->writable()) { return false; }
+            }
+            return true;
+        }
+
+        // Do a single pass of the block with the calling thread's time accounted to it
+        int runOnce() {
+            if (!profiler::isEnabled()) {
+                prepareOutputs();
+                return run();
+            }
+            registerProfile();
+            profiler::setCurrent(&stats);
+            uint64_t start = profiler::now();
+            prepareOutputs();
+            int ret = run();
+            stats.busyNs += profiler::now() - start;
+            stats.runs++;
+            profiler::setCurrent(NULL);
+            return ret;
+        }
+
     protected:
+        // Called before each pass by the thread running the block, lets it resize its outputs to what the pass will need
+        virtual void prepareOutputs() {}
+
+        // Chains running in fused mode need to lock the block while calling its process function
+        template <class T>
+        friend class chain;
+
         void workerLoop() {
-            while (run() >= 0) {}
+            while (runOnce() >= 0) {}
+        }
+
+        void registerProfile() {
+            if (profiled) { return; }
+            profiler::add(this, typeid(*this), &stats);
+            profiled = true;
         }
 
         virtual void doStart() {
+            if (schedulable() && scheduler::isEnabled()) {
+                scheduled = true;
+                scheduler::add(this);
+                return;
+            }
             workerThread = threading::thread("dspBlock:worker", &block::workerLoop, this);
         }
 
@@ -83,6 +140,11 @@ namespace dsp {
                 out->stopWriter();
             }
 
+            if (scheduled) {
+                scheduler::remove(this);
+                scheduled = false;
+            }
+
             // TODO: Make sure this isn't needed, I don't know why it stops
             if (workerThread.joinable()) {
                 workerThread.join();
@@ -130,6 +192,10 @@ namespace dsp {
         bool running = false;
         bool tempStopped = false;
         int tempStopDepth = 0;
+        bool scheduled = false;
         threading::thread workerThread;
+
+        profiler::Stats stats;
+        bool profiled = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "buffer.h"
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <fmt/format.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace dsp::buffer {
+    // Every buffer is preceded by a header telling how to give it back, keeping the user pointer 64 byte aligned
+    struct Header {
+        uint32_t magic;
+        int sizeClass;
+        int backing;
+        size_t capacity;    // Usable bytes after the header
+        size_t mapSize;     // Size of the mapping for mmap'ed buffers
+        Header* next;       // Next buffer in the free list while cached
+    };
+
+    static const uint32_t HEADER_MAGIC = 0x53445242;
+    static const size_t HEADER_SIZE = 64;
+    static_assert(sizeof(Header) <= HEADER_SIZE);
+
+    enum Backing {
+        BACKING_HEAP,
+        BACKING_MMAP,
+        BACKING_HUGETLB
+    };
+
+    // Size classes go four to a power of two from 256 bytes to 256MB, larger buffers aren't pooled
+    static const int MIN_CLASS_LOG = 8;
+    static const int MAX_CLASS_LOG = 28;
+    static const int CLASS_STEPS = 4;
+    static const int CLASS_COUNT = (MAX_CLASS_LOG - MIN_CLASS_LOG) * CLASS_STEPS + 1;
+    static const int NO_CLASS = -1;
+
+    // Buffers at least this large are mapped directly so that they can be backed by hugepages
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static std::mutex classMtx[CLASS_COUNT];
+    static Header* freeLists[CLASS_COUNT];
+
+    static std::atomic<bool> poolEnabled = true;
+    static std::atomic<int64_t> poolLimit = 256ll * 1024 * 1024;
+    static std::atomic<int> hugePages = HUGE_PAGES_OFF;
+
+    static std::atomic<uint64_t> allocCount = 0;
+    static std::atomic<uint64_t> freeCount = 0;
+    static std::atomic<uint64_t> hitCount = 0;
+    static std::atomic<int64_t> inUseBytes = 0;
+    static std::atomic<int64_t> cachedBytes = 0;
+    static std::atomic<int64_t> hugeBytes = 0;
+    static std::atomic<int64_t> thpBytes = 0;
+
+    static std::atomic<int64_t> bytes[_USAGE_COUNT];
+    static std::atomic<int64_t> peakBytes[_USAGE_COUNT];
+    static std::atomic<int64_t> buffers[_USAGE_COUNT];
+    static std::atomic<bool> adaptive = true;
+
+    static int sizeClass(size_t size, size_t& classSize) {
+        if (size <= ((size_t)1 << MIN_CLASS_LOG)) {
+            classSize = (size_t)1 << MIN_CLASS_LOG;
+            return 0;
+        }
+
+        // Find the power of two range the size is in, then the step within it
+        int log = MIN_CLASS_LOG;
+        while (((size_t)1 << (log + 1)) < size) { log++; }
+        if (log >= MAX_CLASS_LOG) {
+            classSize = size;
+            return NO_CLASS;
+        }
+        size_t base = (size_t)1 << log;
+        size_t step = base / CLASS_STEPS;
+        size_t sub = (size - base + step - 1) / step;
+        classSize = base + sub * step;
+        return (log - MIN_CLASS_LOG) * CLASS_STEPS + (int)sub;
+    }
+
+    static Header* systemAlloc(size_t capacity) {
+        size_t total = HEADER_SIZE + capacity;
+        Header* h = NULL;
+        int backing = BACKING_HEAP;
+        size_t mapSize = 0;
+
+#ifdef __linux__
+        int mode = hugePages;
+        if (mode != HUGE_PAGES_OFF && total >= HUGE_PAGE_SIZE) {
+            mapSize = (total + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+            void* mem = MAP_FAILED;
+            if (mode == HUGE_PAGES_EXPLICIT) {
+                mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (mem != MAP_FAILED) { backing = BACKING_HUGETLB; }
+            }
+            if (mem == MAP_FAILED) {
+                mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (mem != MAP_FAILED) {
+                    madvise(mem, mapSize, MADV_HUGEPAGE);
+                    backing = BACKING_MMAP;
+                }
+            }
+            if (mem != MAP_FAILED) {
+                h = (Header*)mem;
+                if (backing == BACKING_HUGETLB) { hugeBytes += mapSize; }
+                else { thpBytes += mapSize; }
+            }
+        }
+#endif
+
+        if (!h) {
+            h = (Header*)volk_malloc(total, std::max<size_t>(HEADER_SIZE, volk_get_alignment()));
+            if (!h) { return NULL; }
+            backing = BACKING_HEAP;
+            mapSize = 0;
+        }
+
+        h->magic = HEADER_MAGIC;
+        h->backing = backing;
+        h->capacity = capacity;
+        h->mapSize = mapSize;
+        h->next = NULL;
+        return h;
+    }
+
+    static void systemFree(Header* h) {
+        h->magic = 0;
+#ifdef __linux__
+        if (h->backing != BACKING_HEAP) {
+            if (h->backing == BACKING_HUGETLB) { hugeBytes -= h->mapSize; }
+            else { thpBytes -= h->mapSize; }
+            munmap(h, h->mapSize);
+            return;
+        }
+#endif
+        volk_free(h);
+    }
+
+    void* allocate(size_t size) {
+        size_t classSize;
+        int sc = sizeClass(size, classSize);
+        allocCount++;
+
+        // Reuse a cached buffer of the same class if there is one
+        Header* h = NULL;
+        if (sc != NO_CLASS) {
+            std::lock_guard<std::mutex> lck(classMtx[sc]);
+            h = freeLists[sc];
+            if (h) { freeLists[sc] = h->next; }
+        }
+        if (h) {
+            hitCount++;
+            cachedBytes -= h->capacity;
+        }
+        else {
+            // Only round up to the class size if the buffer might end up in the pool
+            h = systemAlloc((sc != NO_CLASS && poolEnabled) ? classSize : size);
+            if (!h) { return NULL; }
+            if (!poolEnabled) { sc = NO_CLASS; }
+        }
+
+        h->sizeClass = sc;
+        h->next = NULL;
+        inUseBytes += h->capacity;
+        return (uint8_t*)h + HEADER_SIZE;
+    }
+
+    void free(void* buffer) {
+        if (!buffer) { return; }
+        Header* h = (Header*)((uint8_t*)buffer - HEADER_SIZE);
+        assert(h->magic == HEADER_MAGIC);
+        freeCount++;
+        inUseBytes -= h->capacity;
+
+        // Keep it for later if the pool has room for it. The room is taken before checking so that
+        // concurrent frees can't all see the same free space and push the pool past its limit together.
+        int sc = h->sizeClass;
+        if (sc != NO_CLASS && poolEnabled) {
+            int64_t size = (int64_t)h->capacity;
+            if (cachedBytes.fetch_add(size) + size <= poolLimit) {
+                std::lock_guard<std::mutex> lck(classMtx[sc]);
+                h->next = freeLists[sc];
+                freeLists[sc] = h;
+                return;
+            }
+            cachedBytes -= size;
+        }
+        systemFree(h);
+    }
+
+    void setPoolEnabled(bool enabled) {
+        poolEnabled = enabled;
+        if (!enabled) { trimPool(); }
+    }
+
+    void setPoolLimit(int64_t bytes) {
+        poolLimit = bytes;
+    }
+
+    void setHugePages(HugePages mode) {
+        hugePages = mode;
+    }
+
+    PoolStats getPoolStats() {
+        PoolStats stats;
+        stats.allocations = allocCount;
+        stats.frees = freeCount;
+        stats.hits = hitCount;
+        stats.inUseBytes = inUseBytes;
+        stats.cachedBytes = cachedBytes;
+        stats.hugePageBytes = hugeBytes;
+        stats.thpBytes = thpBytes;
+        return stats;
+    }
+
+    void trimPool() {
+        for (int i = 0; i < CLASS_COUNT; i++) {
+            Header* h;
+            {
+                std::lock_guard<std::mutex> lck(classMtx[i]);
+                h = freeLists[i];
+                freeLists[i] = NULL;
+            }
+            while (h) {
+                Header* next = h->next;
+                cachedBytes -= h->capacity;
+                systemFree(h);
+                h = next;
+            }
+        }
+    }
+
+    void track(Usage usage, int64_t size, int count) {
+        int64_t total = (bytes[usage] += size);
+        buffers[usage] += count;
+
+        // Update the peak, retrying if another thread updated it in the meantime
+        int64_t peak = peakBytes[usage];
+        while (total > peak && !peakBytes[usage].compare_exchange_weak(peak, total)) {}
+    }
+
+    UsageStats getUsage(Usage usage) {
+        UsageStats stats;
+        stats.bytes = bytes[usage];
+        stats.peakBytes = peakBytes[usage];
+        stats.buffers = buffers[usage];
+        return stats;
+    }
+
+    std::string memoryReport() {
+        static const char* names[_USAGE_COUNT] = { "Streams", "Work buffers" };
+        std::string str;
+        for (int i = 0; i < _USAGE_COUNT; i++) {
+            UsageStats stats = getUsage((Usage)i);
+            str += fmt::format("{}: {:.1f} MB in {} buffers (peak {:.1f} MB)\n", names[i], (double)stats.bytes / 1048576.0, stats.buffers, (double)stats.peakBytes / 1048576.0);
+        }
+        PoolStats pool = getPoolStats();
+        double hitRate = pool.allocations ? (double)pool.hits * 100.0 / (double)pool.allocations : 0.0;
+        str += fmt::format("Buffer pool: {:.1f} MB in use, {:.1f} MB cached, {:.1f} MB on hugepages, {:.1f} MB advised as transparent hugepages, {:.1f}% reused\n",
+                           (double)pool.inUseBytes / 1048576.0, (double)pool.cachedBytes / 1048576.0, (double)pool.hugePageBytes / 1048576.0, (double)pool.thpBytes / 1048576.0, hitRate);
+        return str;
+    }
+
+    void setAdaptiveStreams(bool enabled) {
+        adaptive = enabled;
+    }
+
+    bool adaptiveStreams() {
+        return adaptive;
+    }
+}
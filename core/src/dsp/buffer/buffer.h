@@ -1,10 +1,18 @@
 #pragma once
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <algorithm>
 #include <volk/volk.h>
 
 namespace dsp::buffer {
+    // All sample memory comes from a pool of size classes, see buffer.cpp
+    void* allocate(size_t size);
+    void free(void* buffer);
+
     template<class T>
     inline T* alloc(int count) {
-        return (T*)volk_malloc(count * sizeof(T), volk_get_alignment());
+        return (T*)allocate(count * sizeof(T));
     }
 
     template<class T>
@@ -12,7 +20,93 @@ namespace dsp::buffer {
         memset(&buffer[offset], 0, count * sizeof(T));
     }
 
-    inline void free(void* buffer) {
-        volk_free(buffer);
-    }
-}
\ No newline at end of file
+    // Accounting of the memory held by stream buffers and block work buffers
+    enum Usage {
+        USAGE_STREAM,
+        USAGE_WORK,
+        _USAGE_COUNT
+    };
+
+    struct UsageStats {
+        int64_t bytes;
+        int64_t peakBytes;
+        int64_t buffers;
+    };
+
+    void track(Usage usage, int64_t bytes, int buffers);
+    UsageStats getUsage(Usage usage);
+    std::string memoryReport();
+
+    enum HugePages {
+        HUGE_PAGES_OFF,
+        HUGE_PAGES_TRANSPARENT, // Large buffers are advised to the kernel as transparent hugepage candidates
+        HUGE_PAGES_EXPLICIT     // Large buffers are mapped from the hugetlbfs pool, falling back to transparent
+    };
+
+    struct PoolStats {
+        uint64_t allocations;
+        uint64_t frees;
+        uint64_t hits;          // Allocations served from the pool
+        int64_t inUseBytes;
+        int64_t cachedBytes;
+        int64_t hugePageBytes;  // Live and cached memory mapped from the hugetlbfs pool, known to be on hugepages
+        int64_t thpBytes;       // Live and cached memory advised as transparent hugepages, the kernel may or may not have backed it so
+    };
+
+    // Freed buffers are kept for reuse as long as the pool holds less than the limit
+    void setPoolEnabled(bool enabled);
+    void setPoolLimit(int64_t bytes);
+    void setHugePages(HugePages mode);
+    PoolStats getPoolStats();
+
+    // Give all cached buffers back to the system
+    void trimPool();
+
+    // Whether blocks size their output streams to the data they're given instead of the default size
+    void setAdaptiveStreams(bool enabled);
+    bool adaptiveStreams();
+
+    // Default initial size of work buffers that grow with the size of the blocks they're given
+    const int WORK_BUFFER_INITIAL_SIZE = 16384;
+
+    // Work buffer that keeps a history of samples at its start and grows on demand
+    template<class T>
+    class WorkBuffer {
+    public:
+        WorkBuffer() {}
+
+        ~WorkBuffer() {
+            free();
+        }
+
+        // Make sure that count samples fit after the first keep samples, the kept samples are preserved
+        inline T* reserve(int keep, int count) {
+            int needed = keep + count;
+            if (needed <= capacity) { return data; }
+
+            // Grow by at least 50% to avoid reallocating on every small increase
+            int newCapacity = std::max<int>(needed, capacity + (capacity >> 1));
+            T* newData = alloc<T>(newCapacity);
+            if (data) {
+                if (keep > 0) { memcpy(newData, data, keep * sizeof(T)); }
+                buffer::free(data);
+                track(USAGE_WORK, -(int64_t)capacity * sizeof(T), -1);
+            }
+            track(USAGE_WORK, (int64_t)newCapacity * sizeof(T), 1);
+            data = newData;
+            capacity = newCapacity;
+            return data;
+        }
+
+        void free() {
+            if (!data) { return; }
+            buffer::free(data);
+            track(USAGE_WORK, -(int64_t)capacity * sizeof(T), -1);
+            data = NULL;
+            capacity = 0;
+        }
+
+        T* data = NULL;
+        int capacity = 0;
+    };
+}
@@ -15,20 +15,14 @@ namespace dsp::buffer {
         SampleFrameBuffer(stream<T>* in) { init(in); }
 
         ~SampleFrameBuffer() {
+            if (!overflow.name.empty()) { overflow::remove(&overflow); }
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
-                buffer::free(buffers[i]);
-            }
         }
 
         void init(stream<T>* in) {
             _in = in;
 
-            for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
-                buffers[i] = buffer::alloc<T>(STREAM_BUFFER_SIZE);
-            }
-
             base_type::registerInput(in);
             base_type::registerOutput(&out);
             base_type::_block_init = true;
@@ -55,7 +49,9 @@ namespace dsp::buffer {
             if (count < 0) { return -1; }
 
             if (bypass) {
+                out.reserve(count);
                 memcpy(out.writeBuf, _in->readBuf, count * sizeof(T));
+                out.writeMeta = _in->readMeta;
                 _in->flush();
                 if (!out.swap(count)) { return -1; }
                 return count;
@@ -64,8 +60,18 @@ namespace dsp::buffer {
             // Push it on the ring buffer
             {
                 std::lock_guard<std::mutex> lck(bufMtx);
-                memcpy(buffers[writeCur], _in->readBuf, count * sizeof(T));
+
+                // If the ring is full, the oldest frame is lost
+                if (((writeCur + 1) % TEST_BUFFER_SIZE) == readCur) {
+                    overflow.dropped(sizes[readCur]);
+                    readCur = ((readCur + 1) % TEST_BUFFER_SIZE);
+                }
+
+                // Slots only get as large as the blocks they're given
+                T* buf = buffers[writeCur].reserve(0, count);
+                memcpy(buf, _in->readBuf, count * sizeof(T));
                 sizes[writeCur] = count;
+                metas[writeCur] = _in->readMeta;
                 writeCur++;
                 writeCur = ((writeCur) % TEST_BUFFER_SIZE);
             }
@@ -83,7 +89,9 @@ namespace dsp::buffer {
 
                 // Write one to output buffer and unlock in preparation to swap buffers
                 int count = sizes[readCur];
-                memcpy(out.writeBuf, buffers[readCur], count * sizeof(T));
+                out.reserve(count);
+                memcpy(out.writeBuf, buffers[readCur].data, count * sizeof(T));
+                out.writeMeta = metas[readCur];
                 readCur++;
                 readCur = ((readCur) % TEST_BUFFER_SIZE);
                 lck.unlock();
@@ -95,6 +103,9 @@ namespace dsp::buffer {
 
         stream<T> out;
 
+        // Frames lost because the ring was full
+        overflow::Counters overflow;
+
         int writeCur = 0;
         int readCur = 0;
 
@@ -125,8 +136,9 @@ namespace dsp::buffer {
         threading::thread readWorkerThread;
         std::mutex bufMtx;
         std::condition_variable cnd;
-        T* buffers[TEST_BUFFER_SIZE];
+        buffer::WorkBuffer<T> buffers[TEST_BUFFER_SIZE];
         int sizes[TEST_BUFFER_SIZE];
+        Metadata metas[TEST_BUFFER_SIZE];
 
         bool stopWorker = false;
     };
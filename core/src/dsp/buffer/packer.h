@@ -42,7 +42,13 @@ namespace dsp::buffer {
                 return -1;
             }
 
+            // Input sample i goes to position first + i counted from the start of the packet being filled
+            const Metadata& meta = _in->readMeta;
+            int first = read;
+            if (read) { carryTags(meta, first, 0); }
+
             for (int i = 0; i < count; i++) {
+                if (!read) { startPacket(meta, first, i); }
                 out.writeBuf[read++] = _in->readBuf[i];
                 if (read >= samples) {
                     read = 0;
@@ -62,6 +68,27 @@ namespace dsp::buffer {
         stream<T> out;
 
     private:
+        void startPacket(const Metadata& meta, int first, int i) {
+            if (!meta.valid) {
+                out.writeMeta.clear();
+                return;
+            }
+            Metadata m = meta;
+            m.tagCount = 0;
+            m.resample(1, 1, i);
+            out.writeMeta.update(m);
+            carryTags(meta, first, (first + i) / samples);
+        }
+
+        // Add the tags of the input block that fall into the given packet
+        void carryTags(const Metadata& meta, int first, int packet) {
+            for (int i = 0; i < meta.tagCount; i++) {
+                int pos = first + meta.tags[i].offset;
+                if (pos / samples != packet) { continue; }
+                out.writeMeta.addTag(meta.tags[i].type, meta.tags[i].value, pos % samples);
+            }
+        }
+
         int samples = 1;
         int read = 0;
         stream<T>* _in;
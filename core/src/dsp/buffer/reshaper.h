@@ -76,7 +76,7 @@ namespace dsp::buffer {
         }
 
         void loop() {
-            while (run() >= 0)
+            while (base_type::runOnce() >= 0)
                 ;
         }
 
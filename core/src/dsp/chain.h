@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <type_traits>
 #include "processor.h"
 
 namespace dsp {
@@ -11,6 +12,13 @@ namespace dsp {
 
         chain(stream<T>* in) { init(in); }
 
+        ~chain() {
+            if (fused && running) { stopFused(); }
+            if (fusedOut) { delete fusedOut; }
+            if (scratch[0]) { buffer::free(scratch[0]); }
+            if (scratch[1]) { buffer::free(scratch[1]); }
+        }
+
         void init(stream<T>* in) {
             _in = in;
             out = _in;
@@ -18,23 +26,40 @@ namespace dsp {
 
         template<typename Func>
         void setInput(stream<T>* in, Func onOutputChange) {
+            bool restart = pauseFused();
             _in = in;
+            bool found = false;
             for (auto& ln : links) {
                 if (states[ln]) {
                     ln->setInput(_in);
-                    return;
+                    found = true;
+                    break;
                 }
             }
-            out = _in;
-            onOutputChange(out);
+            if (!found) { updateOutput(onOutputChange, true); }
+            if (restart) { startFused(); }
+        }
+
+        template<class B>
+        void addBlock(B* block, bool enabled) {
+            // Keep a way to call the block's own process function for fused mode
+            if constexpr (has_process<B>::value) {
+                procs[block] = processThunk<B>;
+            }
+            addBlock((Processor<T, T>*)block, enabled);
         }
-        
+
         void addBlock(Processor<T, T>* block, bool enabled) {
             // Check if block is already part of the chain
             if (blockExists(block)) {
                 throw std::runtime_error("[chain] Tried to add a block that is already part of the chain");
             }
 
+            // Blocks added without their concrete type or not knowing their output size can't be fused
+            if (fused && !fusable(block)) {
+                throw std::runtime_error("[chain] Tried to add a block that can't be fused to a fused chain");
+            }
+
             // Add to the list
             links.push_back(block);
             states[block] = false;
@@ -52,9 +77,10 @@ namespace dsp {
 
             // Disable the block
             disableBlock(block, onOutputChange);
-        
+
             // Remove block from the list
             states.erase(block);
+            procs.erase(block);
             links.erase(std::find(links.begin(), links.end(), block));
         }
 
@@ -64,10 +90,12 @@ namespace dsp {
             if (!blockExists(block)) {
                 throw std::runtime_error("[chain] Tried to enable a block that isn't part of the chain");
             }
-            
+
             // If already enable, don't do anything
             if (states[block]) { return; }
 
+            bool restart = pauseFused();
+
             // Gather blocks before and after the block to enable
             Processor<T, T>* before = blockBefore(block);
             Processor<T, T>* after = blockAfter(block);
@@ -76,17 +104,16 @@ namespace dsp {
             if (after) {
                 after->setInput(&block->out);
             }
-            else {
-                out = &block->out;
-                onOutputChange(out);
-            }
 
             // Set input of the new block
             block->setInput(before ? &before->out : _in);
 
-            // Start new block
-            if (running) { block->start(); }
+            // Start new block (in fused mode, the chain's worker runs it instead)
+            if (running && !fused) { block->start(); }
             states[block] = true;
+
+            updateOutput(onOutputChange);
+            if (restart) { startFused(); }
         }
 
         template<typename Func>
@@ -95,10 +122,12 @@ namespace dsp {
             if (!blockExists(block)) {
                 throw std::runtime_error("[chain] Tried to disable a block that isn't part of the chain");
             }
-            
+
             // If already disabled, don't do anything
             if (!states[block]) { return; }
 
+            bool restart = pauseFused();
+
             // Stop disabled block
             block->stop();
             states[block] = false;
@@ -111,10 +140,9 @@ namespace dsp {
             if (after) {
                 after->setInput(before ? &before->out : _in);
             }
-            else {
-                out = before ? &before->out : _in;
-                onOutputChange(out);
-            }
+
+            updateOutput(onOutputChange);
+            if (restart) { startFused(); }
         }
 
         template<typename Func>
@@ -141,8 +169,50 @@ namespace dsp {
             }
         }
 
+        // In fused mode, the process function of every enabled block is called in sequence
+        // by a single worker thread instead of each block running its own thread
+        template<typename Func>
+        void setFused(bool enabled, Func onOutputChange) {
+            if (enabled == fused) { return; }
+
+            // Check that every block can be called directly
+            if (enabled) {
+                for (auto& ln : links) {
+                    if (fusable(ln)) { continue; }
+                    throw std::runtime_error("[chain] Tried to fuse a chain containing a block that can't be fused");
+                }
+            }
+
+            // Switch mode with everything stopped
+            bool wasRunning = running;
+            stop();
+            fused = enabled;
+            if (fused && !fusedOut) {
+                fusedOut = new stream<T>;
+                reserveScratch(FUSED_CHUNK_SIZE);
+            }
+            updateOutput(onOutputChange);
+            if (wasRunning) { start(); }
+        }
+
+        bool isFused() {
+            return fused;
+        }
+
+        // The probe follows the output of the chain as blocks get enabled and disabled,
+        // nothing is recorded while the chain only passes its input through
+        void setLatencyProbe(latency::Probe* probe) {
+            if (out != _in) { out->latencyProbe = probe; }
+            latencyProbe = probe;
+        }
+
         void start() {
             if (running) { return; }
+            if (fused) {
+                startFused();
+                running = true;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->start();
@@ -152,6 +222,11 @@ namespace dsp {
 
         void stop() {
             if (!running) { return; }
+            if (fused) {
+                stopFused();
+                running = false;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->stop();
@@ -162,6 +237,25 @@ namespace dsp {
         stream<T>* out;
 
     private:
+        typedef int (*ProcessFunc)(Processor<T, T>* block, int count, const T* in, T* out);
+
+        template<class B, class = void>
+        struct has_process : std::false_type {};
+
+        template<class B>
+        struct has_process<B, std::void_t<decltype(std::declval<B*>()->process(0, (T*)NULL, (T*)NULL))>> : std::true_type {};
+
+        // Some blocks don't have a const input in their process function, they still don't modify it
+        template<class B>
+        static int processThunk(Processor<T, T>* block, int count, const T* in, T* out) {
+            return ((B*)block)->process(count, (T*)in, out);
+        }
+
+        struct FusedBlock {
+            Processor<T, T>* block;
+            ProcessFunc process;
+        };
+
         Processor<T, T>* blockBefore(Processor<T, T>* block) {
             for (auto& ln : links) {
                 if (ln == block) { return NULL; }
@@ -182,13 +276,191 @@ namespace dsp {
             return NULL;
         }
 
+        Processor<T, T>* lastEnabled() {
+            Processor<T, T>* last = NULL;
+            for (auto& ln : links) {
+                if (states[ln]) { last = ln; }
+            }
+            return last;
+        }
+
         bool blockExists(Processor<T, T>* block) {
             return states.find(block) != states.end();
         }
 
+        template<typename Func>
+        void updateOutput(Func onOutputChange, bool force = false) {
+            // A fused chain outputs in its own stream as long as at least one block is enabled
+            Processor<T, T>* last = lastEnabled();
+            stream<T>* newOut = _in;
+            if (last) { newOut = fused ? fusedOut : &last->out; }
+
+            if (newOut == out && !force) { return; }
+            if (latencyProbe && out && out->latencyProbe == latencyProbe) { out->latencyProbe = NULL; }
+            out = newOut;
+            if (latencyProbe && out != _in) { out->latencyProbe = latencyProbe; }
+            onOutputChange(out);
+        }
+
+        bool pauseFused() {
+            if (!fused || !running) { return false; }
+            stopFused();
+            return true;
+        }
+
+        void startFused() {
+            // Take a snapshot of the enabled blocks, the worker is always stopped when they change
+            fusedBlocks.clear();
+            for (auto& ln : links) {
+                if (!states[ln]) { continue; }
+                fusedBlocks.push_back(FusedBlock{ ln, procs[ln] });
+                ln->registerProfile();
+            }
+            if (fusedBlocks.empty()) { return; }
+            workerThread = threading::thread("dspChain:fused", &chain::fusedWorker, this);
+        }
+
+        void stopFused() {
+            if (!workerThread.joinable()) { return; }
+            _in->stopReader();
+            fusedOut->stopWriter();
+            workerThread.join();
+            _in->clearReadStop();
+            fusedOut->clearWriteStop();
+        }
+
+        void fusedWorker() {
+            int last = fusedBlocks.size() - 1;
+            profiler::Stats& firstStats = fusedBlocks[0].block->stats;
+            profiler::Stats& lastStats = fusedBlocks[last].block->stats;
+            while (true) {
+                // Waiting on the input is accounted to the first block
+                bool profiling = profiler::isEnabled();
+                profiler::setCurrent(profiling ? &firstStats : NULL);
+                uint64_t start = profiling ? profiler::now() : 0;
+                int count = _in->read();
+                if (profiling) { firstStats.busyNs += profiler::now() - start; }
+                if (count < 0) { return; }
+
+                // Carry the metadata through the blocks the same way the samples go through them
+                mapFusedMetadata();
+
+                // Make room for what the blocks can write at most
+                int scratchSize, outSize;
+                maxFusedOutputSize(count, scratchSize, outSize);
+                reserveScratch(scratchSize);
+                fusedOut->reserve(outSize);
+
+                // Run the whole chain on one chunk at a time to keep the intermediate data in cache
+                int outCount = 0;
+                for (int offset = 0; offset < count; offset += FUSED_CHUNK_SIZE) {
+                    int n = std::min<int>(count - offset, FUSED_CHUNK_SIZE);
+                    const T* data = &_in->readBuf[offset];
+                    for (int i = 0; i <= last && n; i++) {
+                        auto& fb = fusedBlocks[i];
+                        T* dst = (i == last) ? &fusedOut->writeBuf[outCount] : scratch[i & 1];
+                        uint64_t procStart = profiling ? profiler::now() : 0;
+                        int inCount = n;
+                        {
+                            std::lock_guard<std::recursive_mutex> lck(fb.block->ctrlMtx);
+                            n = fb.process(fb.block, n, data, dst);
+                        }
+                        if (profiling) {
+                            profiler::Stats& st = fb.block->stats;
+                            st.busyNs += profiler::now() - procStart;
+                            if (i) { st.samplesIn += inCount; }
+                            if (i != last) { st.samplesOut += n; }
+                        }
+                        data = dst;
+                    }
+                    outCount += n;
+                }
+
+                _in->flush();
+                if (profiling) {
+                    for (auto& fb : fusedBlocks) { fb.block->stats.runs++; }
+                }
+
+                // Waiting on the output is accounted to the last block
+                profiler::setCurrent(profiling ? &lastStats : NULL);
+                start = profiling ? profiler::now() : 0;
+                if (outCount) {
+                    if (!fusedOut->swap(outCount)) { return; }
+                }
+                if (profiling) { lastStats.busyNs += profiler::now() - start; }
+            }
+        }
+
+        // The worker has to be able to size the buffers between the blocks
+        bool fusable(Processor<T, T>* block) {
+            return procs.find(block) != procs.end() && block->maxOutputSize(0) >= 0;
+        }
+
+        // Largest number of samples written by any but the last block for a single chunk,
+        // and by the last block over all the chunks of the given number of input samples
+        void maxFusedOutputSize(int count, int& scratchSize, int& outSize) {
+            int last = fusedBlocks.size() - 1;
+            scratchSize = 0;
+            outSize = 0;
+            for (int offset = 0; offset < count; offset += FUSED_CHUNK_SIZE) {
+                int n = std::min<int>(count - offset, FUSED_CHUNK_SIZE);
+                for (int i = 0; i <= last; i++) {
+                    auto& fb = fusedBlocks[i];
+                    std::lock_guard<std::recursive_mutex> lck(fb.block->ctrlMtx);
+                    n = fb.block->maxOutputSize(n);
+                    if (i != last) { scratchSize = std::max<int>(scratchSize, n); }
+                }
+                outSize += n;
+            }
+        }
+
+        void reserveScratch(int samples) {
+            if (samples <= scratchCap) { return; }
+            samples += samples >> 2;
+            for (auto& buf : scratch) {
+                if (buf) { buffer::free(buf); }
+                buf = buffer::alloc<T>(samples);
+            }
+            scratchCap = samples;
+        }
+
+        void mapFusedMetadata() {
+            Metadata meta = _in->readMeta;
+            for (auto& fb : fusedBlocks) {
+                if (!meta.valid) { break; }
+                if (fb.block->maxOutputSize(0) < 0) {
+                    meta.clear();
+                    break;
+                }
+                Metadata next;
+                std::lock_guard<std::recursive_mutex> lck(fb.block->ctrlMtx);
+                fb.block->mapMetadata(meta, next);
+                meta = next;
+            }
+            if (meta.valid) {
+                fusedOut->writeMeta.update(meta);
+            }
+            else {
+                fusedOut->writeMeta.clear();
+            }
+        }
+
+        // 256KB of samples in flight through the chain, small enough to stay in L2
+        static const int FUSED_CHUNK_SIZE = (256 * 1024) / (2 * sizeof(T));
+
         stream<T>* _in;
         std::vector<Processor<T, T>*> links;
         std::map<Processor<T, T>*, bool> states;
+        std::map<Processor<T, T>*, ProcessFunc> procs;
         bool running = false;
+        latency::Probe* latencyProbe = NULL;
+
+        // Fused mode
+        bool fused = false;
+        stream<T>* fusedOut = NULL;
+        T* scratch[2] = { NULL, NULL };
+        int scratchCap = 0;
+        std::vector<FusedBlock> fusedBlocks;
+        threading::thread workerThread;
     };
 }
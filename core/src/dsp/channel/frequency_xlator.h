@@ -60,6 +60,8 @@ namespace dsp::channel {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         lv_32fc_t phase;
         lv_32fc_t phaseDelta;
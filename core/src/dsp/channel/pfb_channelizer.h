@@ -0,0 +1,245 @@
+#pragma once
+#include <fftw3.h>
+#include <math.h>
+#include "../sink.h"
+#include "../taps/low_pass.h"
+
+namespace dsp::channel {
+    // Polyphase filterbank channelizer. The input band is split into channelCount channels spaced by
+    // samplerate / channelCount, all of them computed at once by one FFT per output sample. Channels come out
+    // at twice their spacing so that a signal anywhere between two channel centers can be taken from the
+    // nearest one without aliasing. Only the channels with a bound stream are written out.
+    class PFBChannelizer : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        // Fraction of the channel spacing around each channel center passed without attenuation or aliasing
+        static constexpr double PASSBAND = 0.75;
+
+        // Taps of the prototype filter for each channel
+        static const int TAPS_PER_CHANNEL = 16;
+
+        PFBChannelizer() {}
+
+        PFBChannelizer(stream<complex_t>* in, int channelCount) { init(in, channelCount); }
+
+        ~PFBChannelizer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            freeBank();
+        }
+
+        void init(stream<complex_t>* in, int channelCount) {
+            _channelCount = channelCount;
+            buildBank();
+            base_type::init(in);
+        }
+
+        // Planning FFTs isn't thread safe, call from the same thread as the other plans (i.e. not the DSP threads)
+        void setChannelCount(int channelCount) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _channelCount = channelCount;
+            freeBank();
+            buildBank();
+            for (auto& o : outs) { o.channel = std::clamp<int>(o.channel, 0, _channelCount - 1); }
+            base_type::tempStart();
+        }
+
+        int getChannelCount() {
+            return _channelCount;
+        }
+
+        void bindStream(stream<complex_t>* stream, int channel) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (findOutput(stream) != outs.end()) {
+                throw std::runtime_error("[PFBChannelizer] Tried to bind stream to that is already bound");
+            }
+
+            base_type::tempStop();
+            base_type::registerOutput(stream);
+            outs.push_back({ stream, std::clamp<int>(channel, 0, _channelCount - 1) });
+            base_type::tempStart();
+        }
+
+        void unbindStream(stream<complex_t>* stream) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            auto it = findOutput(stream);
+            if (it == outs.end()) {
+                throw std::runtime_error("[PFBChannelizer] Tried to unbind stream to that isn't bound");
+            }
+
+            base_type::tempStop();
+            outs.erase(it);
+            base_type::unregisterOutput(stream);
+            base_type::tempStart();
+        }
+
+        // Move a bound stream to another channel
+        void setChannel(stream<complex_t>* stream, int channel) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            auto it = findOutput(stream);
+            if (it == outs.end()) {
+                throw std::runtime_error("[PFBChannelizer] Tried to retune stream that isn't bound");
+            }
+
+            base_type::tempStop();
+            it->channel = std::clamp<int>(channel, 0, _channelCount - 1);
+            base_type::tempStart();
+        }
+
+        // Channel whose center is the closest to an offset from the center of the input band
+        inline int nearestChannel(double offset, double inSamplerate) {
+            int channel = (int)round(offset * (double)_channelCount / inSamplerate);
+            return ((channel % _channelCount) + _channelCount) % _channelCount;
+        }
+
+        // Offset of the center of a channel from the center of the input band, channels past the middle are negative
+        inline double channelOffset(int channel, double inSamplerate) {
+            if (channel >= _channelCount / 2) { channel -= _channelCount; }
+            return (double)channel * inSamplerate / (double)_channelCount;
+        }
+
+        inline double channelSamplerate(double inSamplerate) {
+            return 2.0 * inSamplerate / (double)_channelCount;
+        }
+
+        // True if a signal of the given bandwidth at the given offset from the center of a channel fits in it
+        inline bool fits(double offset, double bandwidth, double inSamplerate) {
+            return fabs(offset) + (bandwidth / 2.0) <= PASSBAND * inSamplerate / (double)_channelCount;
+        }
+
+        // Recorded once per block handed out, a probe on the bound streams would count it once per stream
+        latency::Probe* latencyProbe = NULL;
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Copy data after the history
+            int histSize = bankSize - 1;
+            complex_t* buffer = work.reserve(histSize, count);
+            memcpy(&buffer[histSize], base_type::_in->readBuf, count * sizeof(complex_t));
+
+            // One output per half a channel count of input, the first one taken offset samples into the block
+            int frames = (offset < count) ? ((count - offset + step - 1) / step) : 0;
+            Metadata meta = base_type::_in->readMeta;
+            if (meta.valid) { meta.resample(1, step, offset); }
+            for (auto& o : outs) { o.out->reserve(frames); }
+
+            // Nothing to compute without any stream bound, the phase still advances for when one gets bound
+            int computed = outs.empty() ? 0 : frames;
+            if (outs.empty() && (frames & 1)) { parity = !parity; }
+
+            for (int f = 0; f < computed; f++) {
+                // Sum the polyphase branches, the bank is laid out so that this is a plain multiply-accumulate
+                const float* x = (const float*)&buffer[offset + f * step];
+                float* sum = (float*)fftIn;
+                int len = 2 * _channelCount;
+                for (int i = 0; i < len; i++) { sum[i] = bank[i] * x[i]; }
+                for (int r = 1; r < TAPS_PER_CHANNEL; r++) {
+                    const float* b = &bank[r * len];
+                    const float* xr = &x[r * len];
+                    for (int i = 0; i < len; i++) { sum[i] += b[i] * xr[i]; }
+                }
+
+                fftwf_execute(plan);
+
+                // The frames start every half a channel count, odd channels flip sign on every other frame
+                for (auto& o : outs) {
+                    complex_t y = fftOut[o.channel] * rotations[o.channel];
+                    if (parity && (o.channel & 1)) { y *= -1.0f; }
+                    o.out->writeBuf[f] = y;
+                }
+                parity = !parity;
+            }
+            offset += frames * step - count;
+
+            // Keep the history for the next block
+            memmove(buffer, &buffer[count], histSize * sizeof(complex_t));
+
+            base_type::_in->flush();
+
+            if (computed) {
+                if (latencyProbe) { latencyProbe->record(meta); }
+                for (auto& o : outs) {
+                    o.out->writeMeta = meta;
+                    if (!o.out->swap(frames)) { return -1; }
+                }
+            }
+            return frames;
+        }
+
+    protected:
+        struct Output {
+            stream<complex_t>* out;
+            int channel;
+        };
+
+        std::vector<Output>::iterator findOutput(stream<complex_t>* stream) {
+            return std::find_if(outs.begin(), outs.end(), [stream](const Output& o) { return o.out == stream; });
+        }
+
+        void buildBank() {
+            step = _channelCount / 2;
+            bankSize = _channelCount * TAPS_PER_CHANNEL;
+
+            // Prototype low-pass, flat over the passband and stopped past one channel spacing so nothing aliases into it.
+            // The tap count per channel gives a transition of just under a quarter of the spacing (see estimateTapCount()).
+            double spacing = 1.0 / (double)_channelCount;
+            tap<float> proto = taps::windowedSinc<float>(bankSize, (PASSBAND + 1.0) * spacing / 2.0, 1.0, window::nuttall);
+
+            // Stored reversed and with each tap repeated for both floats of a sample, the output sample m of the
+            // polyphase sum then comes out in reverse order, which is undone by the FFT along with a constant phase.
+            bank = buffer::alloc<float>(2 * bankSize);
+            for (int i = 0; i < bankSize; i++) {
+                bank[2 * i] = proto.taps[bankSize - 1 - i];
+                bank[2 * i + 1] = proto.taps[bankSize - 1 - i];
+            }
+            taps::free(proto);
+
+            rotations = buffer::alloc<complex_t>(_channelCount);
+            for (int k = 0; k < _channelCount; k++) {
+                double phase = -2.0 * DB_M_PI * (double)k / (double)_channelCount;
+                rotations[k] = complex_t{ (float)cos(phase), (float)sin(phase) };
+            }
+
+            fftIn = (complex_t*)fftwf_malloc(_channelCount * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(_channelCount * sizeof(complex_t));
+            plan = fftwf_plan_dft_1d(_channelCount, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
+
+            complex_t* buf = work.reserve(0, bankSize - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
+            buffer::clear<complex_t>(buf, bankSize - 1);
+            offset = 0;
+            parity = false;
+        }
+
+        void freeBank() {
+            if (!bank) { return; }
+            buffer::free(bank);
+            buffer::free(rotations);
+            fftwf_destroy_plan(plan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            bank = NULL;
+        }
+
+        int _channelCount;
+        int step;
+        int bankSize;
+        float* bank = NULL;
+        complex_t* rotations;
+        complex_t* fftIn;
+        complex_t* fftOut;
+        fftwf_plan plan;
+
+        buffer::WorkBuffer<complex_t> work;
+        int offset = 0;
+        bool parity = false;
+
+        std::vector<Output> outs;
+    };
+}
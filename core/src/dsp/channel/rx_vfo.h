@@ -1,11 +1,16 @@
 #pragma once
 #include "frequency_xlator.h"
 #include "../multirate/rational_resampler.h"
+#include "../filter/freq_xlating_decimating_fir.h"
 
 namespace dsp::channel {
     class RxVFO : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
+        // From this resampling ratio on, the translation is done by the filter of the first decimation instead of
+        // rotating every input sample beforehand
+        static constexpr double XLATING_MIN_RATIO = 8.0;
+
         RxVFO() {}
 
         RxVFO(stream<complex_t>* in, double inSamplerate, double outSamplerate, double bandwidth, double offset) { init(in, inSamplerate, outSamplerate, bandwidth, offset); }
@@ -14,6 +19,7 @@ namespace dsp::channel {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             taps::free(ftaps);
+            taps::free(xtaps);
         }
 
         void init(stream<complex_t>* in, double inSamplerate, double outSamplerate, double bandwidth, double offset) {
@@ -29,6 +35,12 @@ namespace dsp::channel {
             generateTaps();
             filter.init(NULL, ftaps);
 
+            // Dummy initialization since only used for processing
+            xtaps = taps::lowPass(0.25, 0.1, 1.0);
+            xlatingFir.init(NULL, xtaps, 2, 0.0);
+            xlatingFir.out.free();
+            reconfigure();
+
             base_type::init(in);
         }
 
@@ -37,8 +49,7 @@ namespace dsp::channel {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             _inSamplerate = inSamplerate;
-            xlator.setOffset(-_offset, _inSamplerate);
-            resamp.setInSamplerate(_inSamplerate);
+            reconfigure();
             base_type::tempStart();
         }
 
@@ -49,7 +60,7 @@ namespace dsp::channel {
             _outSamplerate = outSamplerate;
             _bandwidth = bandwidth;
             filterNeeded = (_bandwidth != _outSamplerate);
-            resamp.setOutSamplerate(_outSamplerate);
+            reconfigure();
             if (filterNeeded) {
                 generateTaps();
                 filter.setTaps(ftaps);
@@ -73,7 +84,12 @@ namespace dsp::channel {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             _offset = offset;
-            xlator.setOffset(-_offset, _inSamplerate);
+            if (fused) {
+                xlatingFir.setOffset(-_offset, _inSamplerate);
+            }
+            else {
+                xlator.setOffset(-_offset, _inSamplerate);
+            }
         }
 
         void reset() {
@@ -81,13 +97,19 @@ namespace dsp::channel {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             xlator.reset();
+            xlatingFir.reset();
             resamp.reset();
             filter.reset();
             base_type::tempStart();
         }
 
         inline int process(int count, const complex_t* in, complex_t* out) {
-            xlator.process(count, in, out);
+            if (fused) {
+                count = xlatingFir.process(count, in, out);
+            }
+            else {
+                xlator.process(count, in, out);
+            }
             if (!filterNeeded) {
                 return resamp.process(count, out, out);
             }
@@ -113,7 +135,47 @@ namespace dsp::channel {
             return outCount;
         }
 
+        // The translated input is written to the output before being resampled in place
+        int maxOutputSize(int count) { return std::max<int>(count, resamp.maxOutputSize(count)); }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            if (!fused) {
+                resamp.mapMetadata(in, out);
+                return;
+            }
+            Metadata meta;
+            xlatingFir.mapMetadata(in, meta);
+            resamp.mapMetadata(meta, out);
+        }
+
     protected:
+        void reconfigure() {
+            // Translate in the first decimation by the highest power of two that leaves at least twice the output samplerate
+            fused = (_inSamplerate / _outSamplerate >= XLATING_MIN_RATIO);
+            if (!fused) {
+                xlator.setOffset(-_offset, _inSamplerate);
+                resamp.setRates(_inSamplerate, _outSamplerate);
+                return;
+            }
+            int decimation = 1 << (int)floor(log2(_inSamplerate / (2.0 * _outSamplerate)));
+            double intSamplerate = _inSamplerate / (double)decimation;
+
+            // Only what's left of the output band after the resampler has to be kept clear of aliases, the transition
+            // is kept at half the room there is for it so that the stopband is fully reached before anything aliases back.
+            // The taps are short at such a wide transition and get normalized to make up for the ripple of the sinc.
+            double passband = _outSamplerate * 0.55;
+            tap<float> newTaps = taps::lowPass(intSamplerate / 2.0, (intSamplerate - 2.0 * passband) / 2.0, _inSamplerate, true);
+            float gain = 0.0f;
+            for (int i = 0; i < newTaps.size; i++) { gain += newTaps.taps[i]; }
+            for (int i = 0; i < newTaps.size; i++) { newTaps.taps[i] /= gain; }
+            xlatingFir.setTaps(newTaps);
+            taps::free(xtaps);
+            xtaps = newTaps;
+            xlatingFir.setDecimation(decimation);
+            xlatingFir.setOffset(-_offset, _inSamplerate);
+            resamp.setRates(intSamplerate, _outSamplerate);
+        }
+
         void generateTaps() {
             taps::free(ftaps);
             double filterWidth = _bandwidth / 2.0;
@@ -121,6 +183,9 @@ namespace dsp::channel {
         }
 
         FrequencyXlator xlator;
+        filter::FreqXlatingDecimatingFIR xlatingFir;
+        tap<float> xtaps;
+        bool fused;
         multirate::RationalResampler<complex_t> resamp;
         filter::FIR<complex_t, float> filter;
         tap<float> ftaps;
@@ -169,6 +169,19 @@ namespace dsp::clock_recovery {
             return outCount;
         }
 
+        int maxOutputSize(int count) {
+            // Symbols are at least the smallest period minus the largest phase correction apart
+            double minStep = std::max<double>(_omega * (1.0 - _omegaRelLimit) - _muGain, 0.5);
+            return (int)ceil((double)count / minStep) + 1;
+        }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // The first symbol is taken offset + phase samples into the block, the following ones about omega apart
+            Metadata meta = in;
+            meta.resample(1.0 / _omega, (double)offset + pcl.phase);
+            out.update(meta);
+        }
+
     protected:
         void generateInterpTaps() {
             double bw = 0.5 / (double)_interpPhaseCount;
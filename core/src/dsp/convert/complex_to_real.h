@@ -26,5 +26,7 @@ namespace dsp::convert {
             if (!base_type::out.swap(count)) { return -1; }
             return count;
         }
+
+        int maxOutputSize(int count) { return count; }
     };
 }
\ No newline at end of file
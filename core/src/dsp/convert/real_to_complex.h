@@ -37,6 +37,8 @@ namespace dsp::convert {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         float* nullBuf;
 
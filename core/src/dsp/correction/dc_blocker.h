@@ -70,6 +70,8 @@ namespace dsp::correction {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         float _rate;
         T offset;
@@ -156,6 +156,8 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         AGCMode _agcMode;
 
@@ -6,12 +6,8 @@
 #include "../loop/pll.h"
 #include "../convert/l_r_to_stereo.h"
 #include "../convert/real_to_complex.h"
-#include "../convert/complex_to_real.h"
-#include "../math/conjugate.h"
+#include "../channel/frequency_xlator.h"
 #include "../math/delay.h"
-#include "../math/multiply.h"
-#include "../math/add.h"
-#include "../math/subtract.h"
 #include "../multirate/rational_resampler.h"
 
 namespace dsp::demod {
@@ -25,9 +21,6 @@ namespace dsp::demod {
         ~BroadcastFM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(lmr);
-            buffer::free(l);
-            buffer::free(r);
             taps::free(pilotFirTaps);
             taps::free(audioFirTaps);
         }
@@ -44,21 +37,16 @@ namespace dsp::demod {
             pilotFir.init(NULL, pilotFirTaps);
             rtoc.init(NULL);
             pilotPLL.init(NULL, 25000.0 / _samplerate, 0.0, math::hzToRads(19000.0, _samplerate), math::hzToRads(18750.0, _samplerate), math::hzToRads(19250.0, _samplerate));
-            lprDelay.init(NULL, ((pilotFirTaps.size - 1) / 2) + 1);
-            lmrDelay.init(NULL, ((pilotFirTaps.size - 1) / 2) + 1);
+            mpxDelay.init(NULL, ((pilotFirTaps.size - 1) / 2) + 1);
             audioFirTaps = taps::lowPass(15000.0, 4000.0, _samplerate);
-            alFir.init(NULL, audioFirTaps);
-            arFir.init(NULL, audioFirTaps);
+            monoFir.init(NULL, audioFirTaps);
+            stereoFir.init(NULL, audioFirTaps);
             xlator.init(NULL, -57000.0, samplerate);
             rdsResamp.init(NULL, samplerate, 5000.0);
 
-            lmr = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-            l = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-            r = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-
-            lprDelay.out.free();
-            arFir.out.free();
-            alFir.out.free();
+            mpxDelay.out.free();
+            monoFir.out.free();
+            stereoFir.out.free();
             xlator.out.free();
             rdsResamp.out.free();
 
@@ -85,13 +73,12 @@ namespace dsp::demod {
             
             pilotPLL.setFrequencyLimits(math::hzToRads(18750.0, _samplerate), math::hzToRads(19250.0, _samplerate));
             pilotPLL.setInitialFreq(math::hzToRads(19000.0, _samplerate));
-            lprDelay.setDelay(((pilotFirTaps.size - 1) / 2) + 1);
-            lmrDelay.setDelay(((pilotFirTaps.size - 1) / 2) + 1);
+            mpxDelay.setDelay(((pilotFirTaps.size - 1) / 2) + 1);
 
             taps::free(audioFirTaps);
             audioFirTaps = taps::lowPass(15000.0, 4000.0, _samplerate);
-            alFir.setTaps(audioFirTaps);
-            arFir.setTaps(audioFirTaps);
+            monoFir.setTaps(audioFirTaps);
+            stereoFir.setTaps(audioFirTaps);
 
             xlator.setOffset(-57000.0, samplerate);
             rdsResamp.setInSamplerate(samplerate);
@@ -134,10 +121,9 @@ namespace dsp::demod {
             demod.reset();
             pilotFir.reset();
             pilotPLL.reset();
-            lprDelay.reset();
-            lmrDelay.reset();
-            alFir.reset();
-            arFir.reset();
+            mpxDelay.reset();
+            monoFir.reset();
+            stereoFir.reset();
             base_type::tempStart();
         }
 
@@ -152,15 +138,6 @@ namespace dsp::demod {
                 pilotFir.process(count, rtoc.out.writeBuf, pilotFir.out.writeBuf);
                 pilotPLL.process(count, pilotFir.out.writeBuf, pilotPLL.out.writeBuf);
 
-                // Delay
-                lprDelay.process(count, demod.out.writeBuf, demod.out.writeBuf);
-                lmrDelay.process(count, rtoc.out.writeBuf, lmrDelay.out.writeBuf);
-                
-                // conjugate PLL output to down convert twice the L-R signal
-                math::Conjugate::process(count, pilotPLL.out.writeBuf, pilotPLL.out.writeBuf);
-                math::Multiply<dsp::complex_t>::process(count, lmrDelay.out.writeBuf, pilotPLL.out.writeBuf, lmrDelay.out.writeBuf);
-                math::Multiply<dsp::complex_t>::process(count, lmrDelay.out.writeBuf, pilotPLL.out.writeBuf, lmrDelay.out.writeBuf);
-
                 // Do RDS demod
                 if (_rdsOut) {
                     // Translate to 0Hz
@@ -170,24 +147,26 @@ namespace dsp::demod {
                     rdsOutCount = rdsResamp.process(count, rtoc.out.writeBuf, rdsout);
                 }
 
-                // Convert output back to real for further processing
-                convert::ComplexToReal::process(count, lmrDelay.out.writeBuf, lmr);
-
-                // Amplify by 2x
-                volk_32f_s32f_multiply_32f(lmr, lmr, 2.0f, count);
-
-                // Do L = (L+R) + (L-R), R = (L+R) - (L-R)
-                math::Add<float>::process(count, demod.out.writeBuf, lmr, l);
-                math::Subtract<float>::process(count, demod.out.writeBuf, lmr, r);
+                // Delay the MPX to line it up with the PLL's output, both L+R and L-R are taken from it
+                mpxDelay.process(count, demod.out.writeBuf, demod.out.writeBuf);
+
+                // Down convert L-R with twice the pilot's phase and do L = (L+R) + (L-R), R = (L+R) - (L-R) in one pass.
+                // The MPX is real, so 2 * Re(mpx * conj(pilot)^2) reduces to 2 * mpx * (re^2 - im^2).
+                const float* mpx = demod.out.writeBuf;
+                const float* pilot = (const float*)pilotPLL.out.writeBuf;
+                float* lr = (float*)out;
+                for (int i = 0; i < count; i++) {
+                    float re = pilot[2 * i];
+                    float im = pilot[2 * i + 1];
+                    float lmr = 2.0f * mpx[i] * (re * re - im * im);
+                    lr[2 * i] = mpx[i] + lmr;
+                    lr[2 * i + 1] = mpx[i] - lmr;
+                }
 
-                // Filter if needed
+                // Filter both channels at once if needed
                 if (_lowPass) {
-                    alFir.process(count, l, l);
-                    arFir.process(count, r, r);
+                    stereoFir.process(count, out, out);
                 }
-
-                // Interleave into stereo
-                convert::LRToStereo::process(count, l, r, out);
             }
             else {
                 // Process RDS if needed. Note: find a way to not have to copy half the code from the stereo demod
@@ -204,7 +183,7 @@ namespace dsp::demod {
 
                 // Filter if needed
                 if (_lowPass) {
-                    alFir.process(count, demod.out.writeBuf, demod.out.writeBuf);
+                    monoFir.process(count, demod.out.writeBuf, demod.out.writeBuf);
                 }
 
                 // Interleave raw MPX to stereo
@@ -214,6 +193,9 @@ namespace dsp::demod {
             return count;
         }
 
+        // The RDS output isn't registered so a swap on it could block a scheduler worker
+        bool schedulable() { return !_rdsOut; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
@@ -229,6 +211,8 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
         stream<complex_t> rdsOut;
 
     protected:
@@ -244,16 +228,10 @@ namespace dsp::demod {
         convert::RealToComplex rtoc;
         channel::FrequencyXlator xlator;
         loop::PLL pilotPLL;
-        math::Delay<float> lprDelay;
-        math::Delay<complex_t> lmrDelay;
+        math::Delay<float> mpxDelay;
         tap<float> audioFirTaps;
-        filter::FIR<float, float> arFir;
-        filter::FIR<float, float> alFir;
+        filter::FIR<float, float> monoFir;
+        filter::FIR<stereo_t, float> stereoFir;
         multirate::RationalResampler<dsp::complex_t> rdsResamp;
-
-        float* lmr;
-        float* l;
-        float* r;
-        
     };
 }
\ No newline at end of file
@@ -94,6 +94,8 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         double _tone;
         double _samplerate;
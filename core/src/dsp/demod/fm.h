@@ -113,6 +113,8 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         void updateFilter(bool lowPass, bool highPass) {
             std::lock_guard<std::mutex> lck(filterMtx);
@@ -3,6 +3,7 @@
 #include "../math/fast_atan2.h"
 #include "../math/hz_to_rads.h"
 #include "../math/normalize_phase.h"
+#include "../kernel/polar_discriminator.h"
 
 #define USE_QUAD_FM_DEMOD 1
 
@@ -38,20 +39,40 @@ namespace dsp::demod {
             _invDeviation = 1.0 / math::hzToRads(deviation, samplerate);
         }
 
+        // Accuracy of the arctangent, the default error of 1e-5 radians is well below what audio can show
+        void setAccuracy(math::Atan2Accuracy accuracy) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _accuracy = accuracy;
+            base_type::tempStart();
+        }
+
         inline int process(int count, complex_t* in, float* out) {
-            for (int i = 0; i < count; i++) {
 #if !defined(USE_QUAD_FM_DEMOD) || (USE_QUAD_FM_DEMOD == 0)
+            for (int i = 0; i < count; i++) {
                 // Differential Phase FM Demodulation
                 float cphase = in[i].phase();
                 out[i] = math::normalizePhase(cphase - phase) * _invDeviation;
                 phase = cphase;
-#else                
-                // Quadrature FM Demodulation
-                auto y = in[i];
-                out[i] = (y * _din.conj()).phase() * _invDeviation;
-                _din = y;
-#endif                
             }
+#else
+            // Quadrature FM Demodulation
+            switch (_accuracy) {
+                case math::ATAN2_ACCURACY_LOW:
+                    kernel::polarDiscriminator<math::ATAN2_ACCURACY_LOW>(out, in, count, _din, _invDeviation);
+                    break;
+                case math::ATAN2_ACCURACY_MEDIUM:
+                    kernel::polarDiscriminator<math::ATAN2_ACCURACY_MEDIUM>(out, in, count, _din, _invDeviation);
+                    break;
+                case math::ATAN2_ACCURACY_HIGH:
+                    kernel::polarDiscriminator<math::ATAN2_ACCURACY_HIGH>(out, in, count, _din, _invDeviation);
+                    break;
+                case math::ATAN2_ACCURACY_EXACT:
+                    kernel::polarDiscriminator<math::ATAN2_ACCURACY_EXACT>(out, in, count, _din, _invDeviation);
+                    break;
+            }
+#endif
             return count;
         }
 
@@ -77,12 +98,15 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         float _invDeviation;
+        math::Atan2Accuracy _accuracy = math::ATAN2_ACCURACY_MEDIUM;
 #if !defined(USE_QUAD_FM_DEMOD) || (USE_QUAD_FM_DEMOD == 0)
         float phase = 0.0f;
 #else
-       complex_t _din;
+       complex_t _din = { 0.0f, 0.0f };
 #endif
     };
 }
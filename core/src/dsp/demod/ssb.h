@@ -115,6 +115,8 @@ namespace dsp::demod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         double getTranslation() {
             switch(_mode) {
@@ -1,5 +1,7 @@
 #pragma once
 #include "fir.h"
+#include "../kernel/half_band.h"
+#include "../kernel/dot_prod.h"
 
 namespace dsp::filter {
     template <class D, class T>
@@ -12,7 +14,9 @@ namespace dsp::filter {
 
         void init(stream<D>* in, tap<T>& taps, int decimation) {
             _decimation = decimation;
+            base_type::_fastAllowed = false;
             base_type::init(in, taps);
+            updateKernels();
         }
 
         void setTaps(tap<T>& taps) {
@@ -21,6 +25,7 @@ namespace dsp::filter {
             base_type::tempStop();
             offset = 0;
             base_type::setTaps(taps);
+            updateKernels();
             base_type::tempStart();
         }
 
@@ -44,18 +49,37 @@ namespace dsp::filter {
 
         inline int process(int count, const D* in, D* out) {
             // Copy data to work buffer
+            base_type::reserveWork(count);
             memcpy(base_type::bufStart, in, count * sizeof(D));
 
             // Do convolution
             int outCount = 0;
-            for (; offset < count; offset += _decimation) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
+            if constexpr (std::is_same_v<T, float>) {
+                constexpr int channels = std::is_same_v<D, float> ? 1 : 2;
+                if (offset < count) { outCount = (count - offset + _decimation - 1) / _decimation; }
+                if (_decimation == 2 && base_type::symmetric) {
+                    // Dedicated decimate by 2 kernel working on the even and odd samples separately
+                    int planeSize = decim2Taps.planeSize(outCount);
+                    float* planes = phaseBuf.reserve(0, 2 * channels * planeSize);
+                    kernel::splitPhases<channels>(planes, planeSize, (const float*)&base_type::buffer[offset], count + base_type::_taps.size - 1 - offset);
+                    kernel::decimate2<channels>((float*)out, outCount, planes, planeSize, decim2Taps);
                 }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
+                else if (outCount) {
+                    // Real taps, several outputs at once
+                    const D* mirror = lanes.folded ? base_type::mirrorWork(count) : NULL;
+                    kernel::stridedDotProd<channels>((float*)out, 1, outCount, (const float*)&base_type::buffer[offset], _decimation,
+                                                     mirror ? (const float*)&mirror[count - 1 - offset] : NULL, lanes);
                 }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
+                offset += outCount * _decimation;
+            }
+            else if (base_type::symmetric) {
+                const D* mirror = base_type::mirrorWork(count);
+                for (; offset < count; offset += _decimation) {
+                    kernel::foldedDotProd(&out[outCount++], &base_type::buffer[offset], &mirror[count - 1 - offset], base_type::_taps.taps, base_type::_taps.size);
+                }
+            }
+            else {
+                for (; offset < count; offset += _decimation) {
                     volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], (lv_32fc_t*)base_type::_taps.taps, base_type::_taps.size);
                 }
             }
@@ -81,8 +105,26 @@ namespace dsp::filter {
             return outCount;
         }
 
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // The first output is taken offset samples into the block
+            Metadata meta = in;
+            meta.resample(1, _decimation, offset);
+            out.update(meta);
+        }
+
     protected:
+        void updateKernels() {
+            if constexpr (std::is_same_v<T, float>) {
+                constexpr int channels = std::is_same_v<D, float> ? 1 : 2;
+                decim2Taps.init(base_type::_taps.taps, base_type::_taps.size);
+                lanes.init(base_type::_taps.taps, base_type::_taps.size, channels, base_type::symmetric);
+            }
+        }
+
         int _decimation;
         int offset = 0;
+        kernel::Decimate2Taps decim2Taps;
+        kernel::TapLanes lanes;
+        buffer::WorkBuffer<float> phaseBuf;
     };
 }
\ No newline at end of file
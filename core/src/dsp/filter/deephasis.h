@@ -87,6 +87,8 @@ namespace dsp::filter {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         void updateAlpha() {
             float dt = 1.0f / _samplerate;
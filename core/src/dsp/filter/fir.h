@@ -1,6 +1,9 @@
 #pragma once
 #include "../processor.h"
 #include "../taps/tap.h"
+#include "overlap_save.h"
+#include "../kernel/symmetric.h"
+#include "../kernel/dot_prod.h"
 
 namespace dsp::filter {
     template <class D, class T>
@@ -14,17 +17,19 @@ namespace dsp::filter {
         ~FIR() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
         }
 
         virtual void init(stream<D>* in, tap<T>& taps) {
             _taps = taps;
 
-            // Allocate and clear buffer
-            buffer = buffer::alloc<D>(STREAM_BUFFER_SIZE + 64000);
+            // Allocate and clear buffer, it grows later on if given larger blocks
+            buffer = work.reserve(0, _taps.size - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
             bufStart = &buffer[_taps.size - 1];
             buffer::clear<D>(buffer, _taps.size - 1);
 
+            symmetric = kernel::isSymmetric(_taps.taps, _taps.size);
+            updateFast();
+
             base_type::init(in);
         }
 
@@ -34,6 +39,7 @@ namespace dsp::filter {
             base_type::tempStop();
 
             int oldTC = _taps.size;
+            buffer = work.reserve(oldTC - 1, taps.size);
             _taps = taps;
 
             // Update start of buffer
@@ -47,10 +53,25 @@ namespace dsp::filter {
                 memmove(&buffer[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(D));
                 buffer::clear<D>(buffer, _taps.size - oldTC);
             }
+
+            symmetric = kernel::isSymmetric(_taps.taps, _taps.size);
+            updateFast();
             
             base_type::tempStart();
         }
 
+        // Direct convolution costs taps operations per sample while FFT convolution costs about log2(taps),
+        // but with a much larger constant and only when given enough samples at once.
+        // By default, the cheapest is picked from the tap count and the size of each block.
+        void setConvolutionMode(ConvolutionMode mode) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _mode = mode;
+            updateFast();
+            base_type::tempStart();
+        }
+
         virtual void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -61,17 +82,26 @@ namespace dsp::filter {
 
         inline int process(int count, const D* in, D* out) {
             // Copy data to work buffer
+            reserveWork(count);
             memcpy(bufStart, in, count * sizeof(D));
-            
-            // Do convolution
-            for (int i = 0; i < count; i++) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[i], &buffer[i], _taps.taps, _taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], _taps.taps, _taps.size);
+
+            // Do convolution, both methods work on the same buffer so they can be switched at any time
+            if (useFast(count)) {
+                fast.process(count, buffer, out);
+            }
+            else if constexpr (std::is_same_v<T, float>) {
+                // Real taps, blocks of outputs at once
+                constexpr int channels = std::is_same_v<D, float> ? 1 : 2;
+                kernel::convolve<channels>((float*)out, count, (const float*)buffer, _taps.taps, _taps.size, symmetric);
+            }
+            else if (symmetric) {
+                const D* mirror = mirrorWork(count);
+                for (int i = 0; i < count; i++) {
+                    kernel::foldedDotProd(&out[i], &buffer[i], &mirror[count - 1 - i], _taps.taps, _taps.size);
                 }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
+            }
+            else {
+                for (int i = 0; i < count; i++) {
                     volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], (lv_32fc_t*)_taps.taps, _taps.size);
                 }
             }
@@ -93,8 +123,50 @@ namespace dsp::filter {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
+        // Make sure count samples fit in the work buffer after the history
+        inline void reserveWork(int count) {
+            buffer = work.reserve(_taps.size - 1, count);
+            bufStart = &buffer[_taps.size - 1];
+        }
+
+        // Reversed copy of the history and count new samples, the mirror of the samples
+        // starting at buffer[i] for the taps then starts at mirror[count - 1 - i]
+        inline D* mirrorWork(int count) {
+            int len = count + _taps.size - 1;
+            D* mirror = mirrorBuf.reserve(0, len);
+            std::reverse_copy(buffer, &buffer[len], mirror);
+            return mirror;
+        }
+
+        // Build the FFT convolution engine only if it has a chance of being used
+        void updateFast() {
+            bool possible = _fastAllowed && OverlapSave<D, T>::SUPPORTED && _mode != CONVOLUTION_DIRECT && ((int)_taps.size >= OVERLAP_SAVE_MIN_TAPS || _mode == CONVOLUTION_FFT);
+            if (possible) {
+                fast.init(_taps);
+            }
+            else {
+                fast.free();
+            }
+        }
+
+        inline bool useFast(int count) {
+            if (!fast.isReady()) { return false; }
+            return _mode == CONVOLUTION_FFT || OverlapSave<D, T>::faster(_taps.size, count);
+        }
+
         tap<T> _taps;
+        bool symmetric = false;
+        ConvolutionMode _mode = CONVOLUTION_AUTO;
+        OverlapSave<D, T> fast;
+
+        // Blocks deriving from this one that only compute some of the outputs turn it off before init()
+        bool _fastAllowed = true;
+
+        buffer::WorkBuffer<D> work;
+        buffer::WorkBuffer<D> mirrorBuf;
         D* buffer;
         D* bufStart;
     };
@@ -0,0 +1,197 @@
+#pragma once
+#include <mutex>
+#include "../processor.h"
+#include "../taps/tap.h"
+#include "../math/hz_to_rads.h"
+#include "../kernel/symmetric.h"
+#include "../kernel/dot_prod.h"
+
+namespace dsp::filter {
+    // Frequency translation followed by a decimating low-pass filter, done in one pass at the output rate.
+    // Instead of rotating every input sample, the taps are shifted to the offset being tuned to and only the
+    // outputs that are kept get computed, their phase being corrected by a rotator running at the output rate.
+    // The offset has the same meaning as for channel::FrequencyXlator and the taps must be symmetric.
+    class FreqXlatingDecimatingFIR : public Processor<complex_t, complex_t> {
+        using base_type = Processor<complex_t, complex_t>;
+    public:
+        FreqXlatingDecimatingFIR() {}
+
+        FreqXlatingDecimatingFIR(stream<complex_t>* in, tap<float>& taps, int decimation, double offset) { init(in, taps, decimation, offset); }
+
+        FreqXlatingDecimatingFIR(stream<complex_t>* in, tap<float>& taps, int decimation, double offset, double samplerate) { init(in, taps, decimation, offset, samplerate); }
+
+        ~FreqXlatingDecimatingFIR() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        void init(stream<complex_t>* in, tap<float>& taps, int decimation, double offset) {
+            assert(kernel::isSymmetric(taps.taps, taps.size));
+            _taps = taps;
+            _decimation = decimation;
+            _offset = offset;
+            phase = lv_cmake(1.0f, 0.0f);
+
+            // Allocate and clear buffer, it grows later on if given larger blocks
+            buffer = work.reserve(0, _taps.size - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
+            buffer::clear<complex_t>(buffer, _taps.size - 1);
+
+            rotateTaps();
+
+            base_type::init(in);
+        }
+
+        void init(stream<complex_t>* in, tap<float>& taps, int decimation, double offset, double samplerate) {
+            init(in, taps, decimation, math::hzToRads(offset, samplerate));
+        }
+
+        void setTaps(tap<float>& taps) {
+            assert(base_type::_block_init);
+            assert(kernel::isSymmetric(taps.taps, taps.size));
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+
+            // Keep the most recent history, same as FIR::setTaps()
+            int oldTC = _taps.size;
+            buffer = work.reserve(oldTC - 1, taps.size);
+            _taps = taps;
+            if (_taps.size < oldTC) {
+                memmove(buffer, &buffer[oldTC - _taps.size], (_taps.size - 1) * sizeof(complex_t));
+            }
+            else if (_taps.size > oldTC) {
+                memmove(&buffer[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(complex_t));
+                buffer::clear<complex_t>(buffer, _taps.size - oldTC);
+            }
+            rotateTaps();
+
+            base_type::tempStart();
+        }
+
+        void setDecimation(int decimation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _decimation = decimation;
+            offset = 0;
+            rotateTaps();
+            base_type::tempStart();
+        }
+
+        // Retuning doesn't stop the block, the new taps are swapped in between two blocks of samples
+        void setOffset(double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _offset = offset;
+            rotateTaps();
+        }
+
+        void setOffset(double offset, double samplerate) {
+            setOffset(math::hzToRads(offset, samplerate));
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            buffer::clear<complex_t>(buffer, _taps.size - 1);
+            offset = 0;
+            phase = lv_cmake(1.0f, 0.0f);
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const complex_t* in, complex_t* out) {
+            // Copy data after the history
+            buffer = work.reserve(_taps.size - 1, count);
+            memcpy(&buffer[_taps.size - 1], in, count * sizeof(complex_t));
+
+            int outCount = 0;
+            if (offset < count) { outCount = (count - offset + _decimation - 1) / _decimation; }
+            if (outCount) {
+                // Reversed copy of the samples for the folded taps
+                int len = count + _taps.size - 1;
+                complex_t* mirror = mirrorBuf.reserve(0, len);
+                std::reverse_copy(buffer, &buffer[len], mirror);
+
+                std::lock_guard<std::mutex> lck(tapMtx);
+                kernel::stridedRotatedDotProd((float*)out, outCount, (const float*)&buffer[offset], _decimation,
+                                              (const float*)&mirror[count - 1 - offset], reTaps, imTaps);
+
+                // Bring the outputs back to the phase they'd have had if the input had been rotated
+#if VOLK_VERSION >= 030100
+                volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)out, (lv_32fc_t*)out, &phaseDelta, &phase, outCount);
+#else
+                volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)out, (lv_32fc_t*)out, phaseDelta, &phase, outCount);
+#endif
+            }
+            offset += outCount * _decimation - count;
+
+            // Move unused data
+            memmove(buffer, &buffer[count], (_taps.size - 1) * sizeof(complex_t));
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+        int maxOutputSize(int count) { return count; }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // The first output is taken offset samples into the block
+            Metadata meta = in;
+            meta.resample(1, _decimation, offset);
+            out.update(meta);
+        }
+
+    protected:
+        // Shift the taps by the offset around their center tap, which keeps the real part symmetric and makes the
+        // imaginary part antisymmetric. The phase of the center tap is the same for all outputs and gets dropped.
+        void rotateTaps() {
+            int count = _taps.size;
+            double center = (double)(count - 1) / 2.0;
+            std::vector<float> re(count);
+            std::vector<float> im(count);
+            for (int k = 0; k < count; k++) {
+                double angle = _offset * ((double)k - center);
+                re[k] = _taps.taps[k] * (float)cos(angle);
+                im[k] = _taps.taps[k] * (float)sin(angle);
+            }
+
+            kernel::TapLanes newRe;
+            kernel::TapLanes newIm;
+            newRe.init(re.data(), count, 2, true);
+            newIm.init(im.data(), count, 2, true);
+
+            std::lock_guard<std::mutex> lck(tapMtx);
+            reTaps = std::move(newRe);
+            imTaps = std::move(newIm);
+            phaseDelta = lv_cmake((float)cos(_offset * (double)_decimation), (float)sin(_offset * (double)_decimation));
+        }
+
+        tap<float> _taps;
+        int _decimation;
+        double _offset;
+        int offset = 0;
+
+        kernel::TapLanes reTaps;
+        kernel::TapLanes imTaps;
+        std::mutex tapMtx;
+        lv_32fc_t phase;
+        lv_32fc_t phaseDelta;
+
+        buffer::WorkBuffer<complex_t> work;
+        buffer::WorkBuffer<complex_t> mirrorBuf;
+        complex_t* buffer;
+    };
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <math.h>
+#include <type_traits>
+#include <fftw3.h>
+#include "../types.h"
+#include "../taps/tap.h"
+
+namespace dsp::filter {
+    enum ConvolutionMode {
+        CONVOLUTION_AUTO,       // Pick the cheapest of the two for each block
+        CONVOLUTION_DIRECT,
+        CONVOLUTION_FFT
+    };
+
+    // Below this many taps, direct convolution always wins
+    const int OVERLAP_SAVE_MIN_TAPS = 48;
+
+    // Overlap-save fast convolution engine. It works on the same history + input layout as the direct
+    // convolution of the FIR blocks and gives the same result, so that both can be switched between freely.
+    // Planning FFTs isn't thread safe, build it from the same thread as the other plans (i.e. not the DSP threads).
+    template <class D, class T>
+    class OverlapSave {
+    public:
+        static constexpr bool REAL = std::is_same_v<D, float>;
+        static constexpr bool SUPPORTED = (REAL && std::is_same_v<T, float>) || std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>;
+
+        OverlapSave() {}
+
+        ~OverlapSave() { free(); }
+
+        void init(const tap<T>& taps) {
+            free();
+            if constexpr (SUPPORTED) {
+                tapCount = taps.size;
+                fftSize = fftSizeFor(tapCount);
+                segment = fftSize - tapCount + 1;
+                bins = REAL ? (fftSize / 2 + 1) : fftSize;
+
+                timeIn = (D*)fftwf_malloc(fftSize * sizeof(D));
+                timeOut = (D*)fftwf_malloc(fftSize * sizeof(D));
+                freq = (complex_t*)fftwf_malloc(bins * sizeof(complex_t));
+                response = (complex_t*)fftwf_malloc(bins * sizeof(complex_t));
+                if constexpr (REAL) {
+                    forwardPlan = fftwf_plan_dft_r2c_1d(fftSize, timeIn, (fftwf_complex*)freq, FFTW_ESTIMATE);
+                    backwardPlan = fftwf_plan_dft_c2r_1d(fftSize, (fftwf_complex*)freq, timeOut, FFTW_ESTIMATE);
+                }
+                else {
+                    forwardPlan = fftwf_plan_dft_1d(fftSize, (fftwf_complex*)timeIn, (fftwf_complex*)freq, FFTW_FORWARD, FFTW_ESTIMATE);
+                    backwardPlan = fftwf_plan_dft_1d(fftSize, (fftwf_complex*)freq, (fftwf_complex*)timeOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+                }
+
+                // The FIR blocks correlate with the taps, so the response is that of the reversed taps.
+                // The scaling of the unnormalized inverse FFT is folded into it.
+                float scale = 1.0f / (float)fftSize;
+                memset(timeIn, 0, fftSize * sizeof(D));
+                for (int i = 0; i < tapCount; i++) {
+                    if constexpr (std::is_same_v<T, float>) {
+                        if constexpr (REAL) {
+                            timeIn[i] = taps.taps[tapCount - 1 - i] * scale;
+                        }
+                        else {
+                            timeIn[i] = D{ taps.taps[tapCount - 1 - i] * scale, 0.0f };
+                        }
+                    }
+                    else {
+                        timeIn[i] = D{ taps.taps[tapCount - 1 - i].re * scale, taps.taps[tapCount - 1 - i].im * scale };
+                    }
+                }
+                fftwf_execute(forwardPlan);
+                memcpy(response, freq, bins * sizeof(complex_t));
+                ready = true;
+            }
+        }
+
+        void free() {
+            if (!ready) { return; }
+            fftwf_destroy_plan(forwardPlan);
+            fftwf_destroy_plan(backwardPlan);
+            fftwf_free(timeIn);
+            fftwf_free(timeOut);
+            fftwf_free(freq);
+            fftwf_free(response);
+            ready = false;
+        }
+
+        bool isReady() {
+            return ready;
+        }
+
+        // Compute count outputs from count + tapCount - 1 samples of history and input
+        inline void process(int count, const D* in, D* out) {
+            for (int i = 0; i < count; i += segment) {
+                int n = std::min<int>(segment, count - i);
+                int avail = n + tapCount - 1;
+                memcpy(timeIn, &in[i], avail * sizeof(D));
+                if (avail < fftSize) { memset(&timeIn[avail], 0, (fftSize - avail) * sizeof(D)); }
+
+                fftwf_execute(forwardPlan);
+                volk_32fc_x2_multiply_32fc((lv_32fc_t*)freq, (lv_32fc_t*)freq, (lv_32fc_t*)response, bins);
+                fftwf_execute(backwardPlan);
+
+                // The first tapCount - 1 outputs are wrapped around and thrown away
+                memcpy(&out[i], &timeOut[tapCount - 1], n * sizeof(D));
+            }
+        }
+
+        // Rough cost in flops of both methods for a block of count samples
+        static bool faster(int tapCount, int count) {
+            if (!SUPPORTED || tapCount < OVERLAP_SAVE_MIN_TAPS || count <= 0) { return false; }
+            int n = fftSizeFor(tapCount);
+            int seg = n - tapCount + 1;
+            double segments = ceil((double)count / (double)seg);
+
+            // Flops per tap of the dot products
+            double mac = 8.0;
+            if constexpr (REAL) { mac = 2.0; }
+            else if constexpr (std::is_same_v<T, float>) { mac = 4.0; }
+            double direct = (double)count * (double)tapCount * mac;
+
+            // Forward and inverse FFT at about 5N.log2(N) flops each (half for real data) plus the spectrum product.
+            // FFTs get a lower share of the peak throughput than dot products, hence the penalty.
+            double fftFlops = 5.0 * (double)n * log2((double)n);
+            double product = 6.0 * (double)n;
+            if constexpr (REAL) {
+                fftFlops /= 2.0;
+                product /= 2.0;
+            }
+            double fft = segments * (2.0 * fftFlops + product) * FFT_PENALTY;
+
+            return fft < direct;
+        }
+
+        static int fftSizeFor(int tapCount) {
+            // About 4 times the filter length, this keeps most of each FFT useful without making it too large
+            int n = 256;
+            while (n < 4 * tapCount) { n <<= 1; }
+            return n;
+        }
+
+    private:
+        static constexpr double FFT_PENALTY = 2.0;
+
+        bool ready = false;
+        int tapCount = 0;
+        int fftSize = 0;
+        int segment = 0;
+        int bins = 0;
+
+        D* timeIn;
+        D* timeOut;
+        complex_t* freq;
+        complex_t* response;
+
+        fftwf_plan forwardPlan;
+        fftwf_plan backwardPlan;
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace dsp::kernel {
+    // Floats computed together by convolve(), enough independent sums to hide the latency of the multiply-adds
+    // while still fitting in the registers of any SIMD instruction set
+    const int CONVOLVE_LANES = 64;
+
+    // Dot products of consecutive outputs, out[j] = sum(taps[k] * x[j + k]), for samples made of CHANNELS floats.
+    // Consecutive outputs read consecutive samples, so each tap is applied to a whole block of outputs at once:
+    // the sums stay in registers, each tap is loaded once per block and there is no horizontal reduction.
+    // With symmetric taps, the two samples sharing a tap are added first and only the first half of the taps is used.
+    template <int CHANNELS>
+    inline void convolve(float* out, int count, const float* x, const float* taps, int tapCount, bool symmetric) {
+        int total = count * CHANNELS;
+        int half = tapCount / 2;
+        int last = (tapCount - 1) * CHANNELS;
+        float center = (symmetric && (tapCount & 1)) ? taps[half] : 0.0f;
+
+        float acc[CONVOLVE_LANES];
+        for (int j = 0; j < total; j += CONVOLVE_LANES) {
+            int n = std::min<int>(CONVOLVE_LANES, total - j);
+            const float* xj = &x[j];
+            if (n == CONVOLVE_LANES) {
+                // Full blocks have a constant size so the compiler can keep the sums in registers
+                if (symmetric) {
+                    for (int l = 0; l < CONVOLVE_LANES; l++) { acc[l] = center * xj[half * CHANNELS + l]; }
+                    for (int k = 0; k < half; k++) {
+                        float t = taps[k];
+                        const float* a = &xj[k * CHANNELS];
+                        const float* b = &xj[last - k * CHANNELS];
+                        for (int l = 0; l < CONVOLVE_LANES; l++) { acc[l] += t * (a[l] + b[l]); }
+                    }
+                }
+                else {
+                    for (int l = 0; l < CONVOLVE_LANES; l++) { acc[l] = 0.0f; }
+                    for (int k = 0; k < tapCount; k++) {
+                        float t = taps[k];
+                        const float* a = &xj[k * CHANNELS];
+                        for (int l = 0; l < CONVOLVE_LANES; l++) { acc[l] += t * a[l]; }
+                    }
+                }
+            }
+            else {
+                if (symmetric) {
+                    for (int l = 0; l < n; l++) { acc[l] = center * xj[half * CHANNELS + l]; }
+                    for (int k = 0; k < half; k++) {
+                        float t = taps[k];
+                        const float* a = &xj[k * CHANNELS];
+                        const float* b = &xj[last - k * CHANNELS];
+                        for (int l = 0; l < n; l++) { acc[l] += t * (a[l] + b[l]); }
+                    }
+                }
+                else {
+                    for (int l = 0; l < n; l++) { acc[l] = 0.0f; }
+                    for (int k = 0; k < tapCount; k++) {
+                        float t = taps[k];
+                        const float* a = &xj[k * CHANNELS];
+                        for (int l = 0; l < n; l++) { acc[l] += t * a[l]; }
+                    }
+                }
+            }
+            memcpy(&out[j], acc, n * sizeof(float));
+        }
+    }
+
+    // Outputs computed together by stridedDotProd() and the width of the partial sums of each of them
+    const int DOT_PROD_OUTPUTS = 4;
+    const int DOT_PROD_LANES = 16;
+
+    // Real taps repeated for each float of a sample so that they line up with interleaved samples.
+    // For symmetric taps only the first half is kept, the samples sharing a tap being added together first.
+    // That half is padded with zero taps up to whole lanes when it stays within the taps, so that short filters
+    // don't spend most of their time outside of the vectorized loop.
+    class TapLanes {
+    public:
+        void init(const float* taps, int count, int channels, bool symmetric) {
+            folded = symmetric;
+            int used = folded ? (count / 2) : count;
+            int size = used * channels;
+            if (folded) {
+                int padded = ((size + DOT_PROD_LANES - 1) / DOT_PROD_LANES) * DOT_PROD_LANES;
+                if (padded / channels <= count) { size = padded; }
+            }
+            lanes.assign(size, 0.0f);
+            for (int k = 0; k < used; k++) {
+                for (int c = 0; c < channels; c++) { lanes[k * channels + c] = taps[k]; }
+            }
+            center = (folded && (count & 1)) ? taps[count / 2] : 0.0f;
+            centerOffset = (count / 2) * channels;
+        }
+
+        std::vector<float> lanes;
+        bool folded = false;
+        float center = 0.0f;
+        int centerOffset = 0;
+    };
+
+    // OUTPUTS dot products sharing the same taps, each tap vector being loaded once for all of them
+    template <int CHANNELS, int OUTPUTS>
+    inline void dotProdBlock(float* out, int outStride, const float* x, int inStride, const float* mirror, const TapLanes& taps) {
+        const float* t = taps.lanes.data();
+        int len = taps.lanes.size();
+
+        float acc[OUTPUTS][DOT_PROD_LANES] = {};
+        int i = 0;
+        if (taps.folded) {
+            for (; i + DOT_PROD_LANES <= len; i += DOT_PROD_LANES) {
+                for (int o = 0; o < OUTPUTS; o++) {
+                    for (int l = 0; l < DOT_PROD_LANES; l++) { acc[o][l] += t[i + l] * (x[o * inStride + i + l] + mirror[i + l - o * inStride]); }
+                }
+            }
+            for (; i < len; i++) {
+                for (int o = 0; o < OUTPUTS; o++) { acc[o][i % DOT_PROD_LANES] += t[i] * (x[o * inStride + i] + mirror[i - o * inStride]); }
+            }
+        }
+        else {
+            for (; i + DOT_PROD_LANES <= len; i += DOT_PROD_LANES) {
+                for (int o = 0; o < OUTPUTS; o++) {
+                    for (int l = 0; l < DOT_PROD_LANES; l++) { acc[o][l] += t[i + l] * x[o * inStride + i + l]; }
+                }
+            }
+            for (; i < len; i++) {
+                for (int o = 0; o < OUTPUTS; o++) { acc[o][i % DOT_PROD_LANES] += t[i] * x[o * inStride + i]; }
+            }
+        }
+
+        // The lanes are a multiple of the channel count, so each one only ever holds a single channel
+        for (int o = 0; o < OUTPUTS; o++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                float sum = taps.center * x[o * inStride + taps.centerOffset + c];
+                for (int l = c; l < DOT_PROD_LANES; l += CHANNELS) { sum += acc[o][l]; }
+                out[o * outStride + c] = sum;
+            }
+        }
+    }
+
+    // Dot products with the same taps for count outputs spaced by outStride samples, reading samples spaced by inStride.
+    // mirror is only used with folded taps and holds the samples reversed, as for foldedDotProd().
+    template <int CHANNELS>
+    inline void stridedDotProd(float* out, int outStride, int count, const float* x, int inStride, const float* mirror, const TapLanes& taps) {
+        int os = outStride * CHANNELS;
+        int is = inStride * CHANNELS;
+        int j = 0;
+        for (; j + DOT_PROD_OUTPUTS <= count; j += DOT_PROD_OUTPUTS) {
+            dotProdBlock<CHANNELS, DOT_PROD_OUTPUTS>(&out[j * os], os, &x[j * is], is, taps.folded ? &mirror[-j * is] : NULL, taps);
+        }
+        for (; j < count; j++) {
+            dotProdBlock<CHANNELS, 1>(&out[j * os], os, &x[j * is], is, taps.folded ? &mirror[-j * is] : NULL, taps);
+        }
+    }
+
+    // Outputs computed together by stridedRotatedDotProd(), half as many as stridedDotProd() since each needs two sums
+    const int ROTATED_DOT_PROD_OUTPUTS = DOT_PROD_OUTPUTS / 2;
+
+    // Dot products of complex samples with complex taps whose real part re is symmetric and imaginary part im is
+    // antisymmetric, which is what low-pass taps shifted in frequency around their center tap look like.
+    // Both parts are folded: the real part on the sum of mirrored samples and the imaginary part on their difference.
+    template <int OUTPUTS>
+    inline void rotatedDotProdBlock(float* out, const float* x, int inStride, const float* mirror, const TapLanes& re, const TapLanes& im) {
+        const float* tr = re.lanes.data();
+        const float* ti = im.lanes.data();
+        int len = re.lanes.size();
+
+        float accRe[OUTPUTS][DOT_PROD_LANES] = {};
+        float accIm[OUTPUTS][DOT_PROD_LANES] = {};
+        int i = 0;
+        for (; i + DOT_PROD_LANES <= len; i += DOT_PROD_LANES) {
+            for (int o = 0; o < OUTPUTS; o++) {
+                for (int l = 0; l < DOT_PROD_LANES; l++) {
+                    float a = x[o * inStride + i + l];
+                    float b = mirror[i + l - o * inStride];
+                    accRe[o][l] += tr[i + l] * (a + b);
+                    accIm[o][l] += ti[i + l] * (a - b);
+                }
+            }
+        }
+        for (; i < len; i++) {
+            for (int o = 0; o < OUTPUTS; o++) {
+                float a = x[o * inStride + i];
+                float b = mirror[i - o * inStride];
+                accRe[o][i % DOT_PROD_LANES] += tr[i] * (a + b);
+                accIm[o][i % DOT_PROD_LANES] += ti[i] * (a - b);
+            }
+        }
+
+        // Even lanes hold the real part of the samples and odd lanes the imaginary part
+        for (int o = 0; o < OUTPUTS; o++) {
+            float rr = re.center * x[o * inStride + re.centerOffset];
+            float ri = re.center * x[o * inStride + re.centerOffset + 1];
+            float ir = 0.0f;
+            float ii = 0.0f;
+            for (int l = 0; l < DOT_PROD_LANES; l += 2) {
+                rr += accRe[o][l];
+                ri += accRe[o][l + 1];
+                ir += accIm[o][l];
+                ii += accIm[o][l + 1];
+            }
+            out[2 * o] = rr - ii;
+            out[2 * o + 1] = ri + ir;
+        }
+    }
+
+    // Complex outputs of rotatedDotProdBlock() for count consecutive outputs, reading samples spaced by inStride.
+    // mirror holds the samples reversed, as for foldedDotProd().
+    inline void stridedRotatedDotProd(float* out, int count, const float* x, int inStride, const float* mirror, const TapLanes& re, const TapLanes& im) {
+        int is = inStride * 2;
+        int j = 0;
+        for (; j + ROTATED_DOT_PROD_OUTPUTS <= count; j += ROTATED_DOT_PROD_OUTPUTS) {
+            rotatedDotProdBlock<ROTATED_DOT_PROD_OUTPUTS>(&out[j * 2], &x[j * is], is, &mirror[-j * is], re, im);
+        }
+        for (; j < count; j++) {
+            rotatedDotProdBlock<1>(&out[j * 2], &x[j * is], is, &mirror[-j * is], re, im);
+        }
+    }
+}
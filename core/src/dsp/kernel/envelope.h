@@ -0,0 +1,44 @@
+#pragma once
+#include <math.h>
+#include <type_traits>
+#include <algorithm>
+#include "../types.h"
+
+namespace dsp::kernel {
+    // Amplitude of each sample. The samples are read as plain floats so that the loop gets vectorized.
+    template <class T>
+    inline void amplitude(float* out, const T* in, int count) {
+        const float* x = (const float*)in;
+        if constexpr (std::is_same_v<T, complex_t>) {
+            for (int i = 0; i < count; i++) { out[i] = sqrtf(x[2 * i] * x[2 * i] + x[2 * i + 1] * x[2 * i + 1]); }
+        }
+        else {
+            for (int i = 0; i < count; i++) { out[i] = fabsf(x[i]); }
+        }
+    }
+
+    // Largest amplitude from each sample up to the end of the block, out[i] = max(in[i], ..., in[count - 1])
+    inline void suffixMax(float* out, const float* in, int count) {
+        float max = 0.0f;
+        for (int i = count - 1; i >= 0; i--) {
+            max = std::max<float>(max, in[i]);
+            out[i] = max;
+        }
+    }
+
+    // Each sample multiplied by its own gain, in and out may be the same buffer
+    template <class T>
+    inline void scale(T* out, const T* in, const float* gain, int count) {
+        const float* x = (const float*)in;
+        float* y = (float*)out;
+        if constexpr (std::is_same_v<T, complex_t>) {
+            for (int i = 0; i < count; i++) {
+                y[2 * i] = x[2 * i] * gain[i];
+                y[2 * i + 1] = x[2 * i + 1] * gain[i];
+            }
+        }
+        else {
+            for (int i = 0; i < count; i++) { y[i] = x[i] * gain[i]; }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <string.h>
+#include <vector>
+#include "symmetric.h"
+
+namespace dsp::kernel {
+    // Half-band filters are symmetric, have an odd length and all taps an even distance away from the center are zero
+    inline bool isHalfBand(const float* taps, int count) {
+        if (count < 3 || !(count & 1) || !isSymmetric(taps, count)) { return false; }
+
+        int center = count / 2;
+        float tol = fabsf(taps[center]) * SYMMETRY_TOLERANCE;
+        for (int i = center - 2; i >= 0; i -= 2) {
+            if (fabsf(taps[i]) > tol) { return false; }
+        }
+        return true;
+    }
+
+    // Outputs computed together by decimate2(), enough independent sums to keep the multipliers busy
+    const int DECIMATE2_BLOCK = 64;
+
+    // Symmetric taps of a decimate by 2 filter split by parity. Tap k applies to sample k / 2 of phase k % 2,
+    // so each parity becomes a regular filter running at the output rate. Only the first half of the taps is kept
+    // since symmetry pairs them with the second half, and the zero taps of half-band filters are dropped altogether.
+    class Decimate2Taps {
+    public:
+        void init(const float* taps, int count) {
+            tapCount = count;
+            half = count / 2;
+            halfBand = isHalfBand(taps, count);
+            center = (count & 1) ? taps[half] : 0.0f;
+            for (int p = 0; p < 2; p++) {
+                phase[p].clear();
+                if (halfBand && p == (half & 1)) { continue; }
+                for (int k = p; k < half; k += 2) { phase[p].push_back(taps[k]); }
+            }
+        }
+
+        // Number of samples of a phase needed to compute count outputs, rounded up to whole blocks of outputs
+        inline int planeSize(int count) {
+            return ((count + DECIMATE2_BLOCK - 1) / DECIMATE2_BLOCK) * DECIMATE2_BLOCK + half;
+        }
+
+        int tapCount = 0;
+        int half = 0;
+        bool halfBand = false;
+        float center = 0.0f;
+        std::vector<float> phase[2];
+    };
+
+    // Split interleaved samples of CHANNELS floats into the planes used by decimate2(),
+    // plane p * CHANNELS + c holding channel c of the samples with the parity p. The rest of the planes is zeroed.
+    template <int CHANNELS>
+    inline void splitPhases(float* planes, int planeSize, const float* x, int count) {
+        for (int p = 0; p < 2; p++) {
+            int n = (count - p + 1) / 2;
+            for (int c = 0; c < CHANNELS; c++) {
+                float* plane = &planes[(p * CHANNELS + c) * planeSize];
+                for (int i = 0; i < n; i++) {
+                    plane[i] = x[(2 * i + p) * CHANNELS + c];
+                }
+                memset(&plane[n], 0, (planeSize - n) * sizeof(float));
+            }
+        }
+    }
+
+    // Decimate by 2 from planes filled by splitPhases(), the first output lines up with the first sample given to it.
+    // Consecutive outputs read consecutive samples of each plane, so blocks of outputs are computed together with each
+    // tap applied to the whole block at once. This vectorizes well even with the few taps of each phase.
+    template <int CHANNELS>
+    inline void decimate2(float* out, int count, const float* planes, int planeSize, const Decimate2Taps& taps) {
+        // Tap k of parity p pairs up with tap last - k which lands in phase q
+        int last = taps.tapCount - 1;
+        int tapCounts[2];
+        int mirrorOffset[2];
+        for (int p = 0; p < 2; p++) {
+            tapCounts[p] = taps.phase[p].size();
+            mirrorOffset[p] = (((last - p) & 1) * CHANNELS) * planeSize + (last - p) / 2;
+        }
+        int centerOffset = ((taps.half & 1) * CHANNELS) * planeSize + taps.half / 2;
+        float center = (taps.tapCount & 1) ? taps.center : 0.0f;
+
+        float acc[DECIMATE2_BLOCK];
+        for (int j = 0; j < count; j += DECIMATE2_BLOCK) {
+            int n = std::min<int>(DECIMATE2_BLOCK, count - j);
+            for (int c = 0; c < CHANNELS; c++) {
+                const float* chan = &planes[c * planeSize + j];
+                const float* x = &chan[centerOffset];
+                for (int o = 0; o < DECIMATE2_BLOCK; o++) { acc[o] = center * x[o]; }
+
+                for (int p = 0; p < 2; p++) {
+                    const float* a = &chan[p * CHANNELS * planeSize];
+                    const float* b = &chan[mirrorOffset[p]];
+                    const float* t = taps.phase[p].data();
+                    for (int i = 0; i < tapCounts[p]; i++) {
+                        for (int o = 0; o < DECIMATE2_BLOCK; o++) {
+                            acc[o] += t[i] * (a[i + o] + b[o - i]);
+                        }
+                    }
+                }
+
+                for (int o = 0; o < n; o++) { out[(j + o) * CHANNELS + c] = acc[o]; }
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "../types.h"
+#include "../math/phasor.h"
+
+namespace dsp::kernel {
+    // Mix samples down with an oscillator running open loop, out[i] = in[i] * e^(-j * (phase + i * freq)).
+    // With nothing fed back, the angle of every sample is known up front and the loop gets vectorized.
+    // in and out may be the same buffer.
+    inline void ncoMix(complex_t* out, const complex_t* in, int count, float phase, float freq) {
+        const float* x = (const float*)in;
+        float* y = (float*)out;
+        for (int i = 0; i < count; i++) {
+            complex_t p = math::fastPhasor(-(phase + (float)i * freq));
+            float re = x[2 * i] * p.re - x[2 * i + 1] * p.im;
+            float im = x[2 * i] * p.im + x[2 * i + 1] * p.re;
+            y[2 * i] = re;
+            y[2 * i + 1] = im;
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "../types.h"
+#include "../math/fast_atan2.h"
+
+namespace dsp::kernel {
+    // Phase difference between consecutive samples times gain, from the angle of each sample multiplied by the
+    // conjugate of the previous one. last is the sample before in[0] and is updated to the last one of the block.
+    // Every output only depends on two inputs, so the loop is vectorized along with polyAtan2().
+    template <math::Atan2Accuracy ACCURACY>
+    inline void polarDiscriminator(float* out, const complex_t* in, int count, complex_t& last, float gain) {
+        if (count <= 0) { return; }
+
+        // The first sample pairs up with the end of the previous block
+        out[0] = math::polyAtan2<ACCURACY>(in[0].im * last.re - in[0].re * last.im, in[0].re * last.re + in[0].im * last.im) * gain;
+
+        const float* cur = (const float*)&in[1];
+        const float* prev = (const float*)&in[0];
+        for (int i = 0; i < count - 1; i++) {
+            float re = cur[2 * i] * prev[2 * i] + cur[2 * i + 1] * prev[2 * i + 1];
+            float im = cur[2 * i + 1] * prev[2 * i] - cur[2 * i] * prev[2 * i + 1];
+            out[i + 1] = math::polyAtan2<ACCURACY>(im, re) * gain;
+        }
+
+        last = in[count - 1];
+    }
+}
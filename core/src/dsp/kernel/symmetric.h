@@ -0,0 +1,92 @@
+#pragma once
+#include <math.h>
+#include <algorithm>
+#include <type_traits>
+#include "../types.h"
+
+namespace dsp::kernel {
+    // Taps are considered symmetric if mirrored taps differ by less than this, relative to the largest tap
+    const float SYMMETRY_TOLERANCE = 1e-6f;
+
+    template <class T>
+    inline bool isSymmetric(const T* taps, int count) {
+        if (count < 2) { return false; }
+
+        float max = 0.0f;
+        for (int i = 0; i < count; i++) {
+            if constexpr (std::is_same_v<T, float>) {
+                max = std::max<float>(max, fabsf(taps[i]));
+            }
+            else {
+                max = std::max<float>(max, std::max<float>(fabsf(taps[i].re), fabsf(taps[i].im)));
+            }
+        }
+
+        float tol = max * SYMMETRY_TOLERANCE;
+        for (int i = 0; i < count / 2; i++) {
+            const T& a = taps[i];
+            const T& b = taps[count - 1 - i];
+            if constexpr (std::is_same_v<T, float>) {
+                if (fabsf(a - b) > tol) { return false; }
+            }
+            else {
+                if (fabsf(a.re - b.re) > tol || fabsf(a.im - b.im) > tol) { return false; }
+            }
+        }
+        return true;
+    }
+
+    // Dot product of count samples with symmetric taps, the mirrored samples are added before being multiplied
+    // so only the first half of the taps gets used. mirror holds the same samples as x in reverse order
+    // (mirror[i] == x[count - 1 - i]) so that both can be read forward, which is what lets the loop vectorize.
+    template <class D, class T>
+    inline void foldedDotProd(D* out, const D* x, const D* mirror, const T* taps, int count) {
+        int half = count / 2;
+        if constexpr (std::is_same_v<D, float>) {
+            float acc = 0.0f;
+            for (int i = 0; i < half; i++) {
+                acc += taps[i] * (x[i] + mirror[i]);
+            }
+            if (count & 1) { acc += taps[half] * x[half]; }
+            *out = acc;
+        }
+        else if constexpr (std::is_same_v<T, float>) {
+            // Complex and stereo samples with real taps, both channels are independent
+            const float* xf = (const float*)x;
+            const float* mf = (const float*)mirror;
+            float a = 0.0f;
+            float b = 0.0f;
+            for (int i = 0; i < half; i++) {
+                a += taps[i] * (xf[2 * i] + mf[2 * i]);
+                b += taps[i] * (xf[2 * i + 1] + mf[2 * i + 1]);
+            }
+            if (count & 1) {
+                a += taps[half] * xf[2 * half];
+                b += taps[half] * xf[2 * half + 1];
+            }
+            float* of = (float*)out;
+            of[0] = a;
+            of[1] = b;
+        }
+        else {
+            // Complex taps
+            const float* xf = (const float*)x;
+            const float* mf = (const float*)mirror;
+            float re = 0.0f;
+            float im = 0.0f;
+            for (int i = 0; i < half; i++) {
+                float sre = xf[2 * i] + mf[2 * i];
+                float sim = xf[2 * i + 1] + mf[2 * i + 1];
+                re += sre * taps[i].re - sim * taps[i].im;
+                im += sre * taps[i].im + sim * taps[i].re;
+            }
+            if (count & 1) {
+                re += xf[2 * half] * taps[half].re - xf[2 * half + 1] * taps[half].im;
+                im += xf[2 * half] * taps[half].im + xf[2 * half + 1] * taps[half].re;
+            }
+            float* of = (float*)out;
+            of[0] = re;
+            of[1] = im;
+        }
+    }
+}
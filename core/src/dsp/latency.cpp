@@ -0,0 +1,183 @@
+#include "latency.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <mutex>
+#include <fmt/format.h>
+
+namespace dsp::latency {
+    static std::atomic<bool> enabled = false;
+    static std::mutex mtx;
+    static std::vector<Probe*> probes;
+    static std::map<std::string, std::string> upstreams;
+
+    double bucketEdge(int bucket) {
+        return BUCKET_FIRST_MS * pow(2.0, (double)(bucket + 1) / (double)BUCKETS_PER_OCTAVE);
+    }
+
+    static int bucketOf(int64_t ns) {
+        double ms = (double)ns * 1e-6;
+        if (ms <= BUCKET_FIRST_MS) { return 0; }
+        int bucket = (int)(log2(ms / BUCKET_FIRST_MS) * BUCKETS_PER_OCTAVE);
+        return std::clamp<int>(bucket, 0, BUCKET_COUNT - 1);
+    }
+
+    void setEnabled(bool enable) {
+        enabled = enable;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    Probe::~Probe() {
+        if (!name.empty()) { remove(this); }
+    }
+
+    void Probe::record(const Metadata& meta, int64_t extraNs) {
+        if (!enabled || !meta.valid) { return; }
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        int64_t ns = std::max<int64_t>(now - meta.timestamp + extraNs, 0);
+
+        buckets[bucketOf(ns)]++;
+        count++;
+        totalNs += ns;
+
+        // Only one thread writes to a given probe most of the time, the loops almost never spin
+        int64_t cur = minNs;
+        while (ns < cur && !minNs.compare_exchange_weak(cur, ns)) {}
+        cur = maxNs;
+        while (ns > cur && !maxNs.compare_exchange_weak(cur, ns)) {}
+    }
+
+    void Probe::reset() {
+        for (auto& b : buckets) { b = 0; }
+        count = 0;
+        totalNs = 0;
+        minNs = INT64_MAX;
+        maxNs = 0;
+    }
+
+    void add(const std::string& name, Probe* probe, const std::string& upstream) {
+        std::lock_guard<std::mutex> lck(mtx);
+        probe->name = name;
+        if (!upstream.empty()) { upstreams[name] = upstream; }
+        if (std::find(probes.begin(), probes.end(), probe) == probes.end()) { probes.push_back(probe); }
+    }
+
+    void remove(Probe* probe) {
+        std::lock_guard<std::mutex> lck(mtx);
+        probes.erase(std::remove(probes.begin(), probes.end(), probe), probes.end());
+    }
+
+    void link(const std::string& name, const std::string& upstream) {
+        std::lock_guard<std::mutex> lck(mtx);
+        upstreams[name] = upstream;
+    }
+
+    static double percentile(const std::vector<uint64_t>& histogram, uint64_t count, double p, double max) {
+        uint64_t target = (uint64_t)ceil((double)count * p);
+        uint64_t sum = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            sum += histogram[i];
+            if (sum >= target) { return std::min<double>(bucketEdge(i), max); }
+        }
+        return max;
+    }
+
+    std::vector<Info> snapshot() {
+        std::vector<Info> infos;
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            for (auto p : probes) {
+                Info info;
+                info.name = p->name;
+                info.depth = 0;
+                info.stage = 0.0;
+                info.histogram.resize(BUCKET_COUNT);
+                info.count = 0;
+                for (int i = 0; i < BUCKET_COUNT; i++) {
+                    info.histogram[i] = p->buckets[i];
+                    info.count += info.histogram[i];
+                }
+                if (!info.count) { continue; }
+                info.min = (double)p->minNs * 1e-6;
+                info.max = (double)p->maxNs * 1e-6;
+                info.avg = (double)p->totalNs * 1e-6 / (double)std::max<uint64_t>(p->count, 1);
+                info.p50 = percentile(info.histogram, info.count, 0.5, info.max);
+                info.p90 = percentile(info.histogram, info.count, 0.9, info.max);
+                info.p99 = percentile(info.histogram, info.count, 0.99, info.max);
+                infos.push_back(info);
+            }
+
+            // Link each probe to the closest one upstream that saw blocks, skipping the others
+            std::map<std::string, int> index;
+            for (int i = 0; i < infos.size(); i++) { index[infos[i].name] = i; }
+            for (auto& info : infos) {
+                std::string name = info.name;
+                for (int i = 0; i < upstreams.size(); i++) {
+                    auto it = upstreams.find(name);
+                    if (it == upstreams.end()) { break; }
+                    name = it->second;
+                    if (index.find(name) == index.end()) { continue; }
+                    info.upstream = name;
+                    break;
+                }
+            }
+        }
+
+        // Walk down from each probe that has nothing upstream, so that every probe comes right after the path leading to it
+        std::map<std::string, std::vector<int>> children;
+        std::vector<int> roots;
+        for (int i = 0; i < infos.size(); i++) {
+            if (infos[i].upstream.empty()) { roots.push_back(i); }
+            else { children[infos[i].upstream].push_back(i); }
+        }
+        std::vector<Info> ordered;
+        std::vector<bool> visited(infos.size(), false);
+        std::vector<std::pair<int, int>> todo;
+        for (int i = roots.size() - 1; i >= 0; i--) { todo.push_back(std::make_pair(roots[i], -1)); }
+        while (!todo.empty()) {
+            auto [id, parent] = todo.back();
+            todo.pop_back();
+            Info info = infos[id];
+            if (parent >= 0) {
+                info.depth = ordered[parent].depth + 1;
+                info.stage = info.avg - ordered[parent].avg;
+            }
+            else {
+                info.stage = info.avg;
+            }
+            ordered.push_back(info);
+            auto& next = children[info.name];
+            for (int i = next.size() - 1; i >= 0; i--) { todo.push_back(std::make_pair(next[i], ordered.size() - 1)); }
+            visited[id] = true;
+        }
+
+        // Probes linked in a loop have no start, list them on their own
+        for (int i = 0; i < infos.size(); i++) {
+            if (visited[i]) { continue; }
+            infos[i].upstream.clear();
+            infos[i].stage = infos[i].avg;
+            ordered.push_back(infos[i]);
+        }
+        return ordered;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lck(mtx);
+        for (auto p : probes) { p->reset(); }
+    }
+
+    std::string report() {
+        auto infos = snapshot();
+        if (infos.empty()) { return ""; }
+        std::string str = fmt::format("{:>10} {:>9} {:>9} {:>9} {:>9}  {}\n", "Stage", "Median", "P90", "P99", "Max", "Probe");
+        for (const auto& info : infos) {
+            str += fmt::format("{:>+8.1f}ms {:>7.1f}ms {:>7.1f}ms {:>7.1f}ms {:>7.1f}ms  {}{} ({} blocks)\n",
+                               info.stage, info.p50, info.p90, info.p99, info.max, std::string(2 * info.depth, ' '), info.name, info.count);
+        }
+        return str;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "metadata.h"
+
+namespace dsp {
+    // Latency of the signal path measured from the capture timestamp sources put in the block metadata.
+    // Probes are placed at the output of the stages of interest and record how long ago the first sample
+    // of each block going through them was captured, so every probe gives the latency accumulated up to it.
+    // Each probe can name the one upstream of it, the latency added by a stage is the difference between the two.
+    namespace latency {
+        // Histogram of 4 buckets per octave starting at 0.1ms, the last one goes up to about 6.5s
+        const int BUCKET_COUNT = 64;
+        const double BUCKET_FIRST_MS = 0.1;
+        const int BUCKETS_PER_OCTAVE = 4;
+
+        // Upper edge of a bucket in milliseconds
+        double bucketEdge(int bucket);
+
+        void setEnabled(bool enabled);
+        bool isEnabled();
+
+        class Probe {
+        public:
+            ~Probe();
+
+            // Record a block, extraNs is added for delays after this point that the caller knows of
+            void record(const Metadata& meta, int64_t extraNs = 0);
+
+            void reset();
+
+            std::atomic<uint64_t> buckets[BUCKET_COUNT] = {};
+            std::atomic<uint64_t> count = 0;
+            std::atomic<int64_t> totalNs = 0;
+            std::atomic<int64_t> minNs = INT64_MAX;
+            std::atomic<int64_t> maxNs = 0;
+
+            std::string name;
+        };
+
+        struct Info {
+            std::string name;
+            std::string upstream;   // Closest upstream probe that saw blocks, empty if none
+            int depth;              // Number of such probes upstream
+            uint64_t count;
+            double stage;       // Milliseconds added since the upstream probe
+            double min;         // Milliseconds
+            double avg;         // Milliseconds
+            double p50;         // Milliseconds
+            double p90;         // Milliseconds
+            double p99;         // Milliseconds
+            double max;         // Milliseconds
+            std::vector<uint64_t> histogram;
+        };
+
+        void add(const std::string& name, Probe* probe, const std::string& upstream = "");
+        void remove(Probe* probe);
+
+        // Set the probe upstream of another. Links are made by name so that they survive either probe being
+        // removed and added again, and can be made before the probes exist.
+        void link(const std::string& name, const std::string& upstream);
+
+        // Probes that saw at least one block, each path from upstream to downstream with the branches after their common part
+        std::vector<Info> snapshot();
+        void reset();
+
+        // Human readable list of the probes with the latency added by each stage
+        std::string report();
+    }
+}
@@ -1,7 +1,11 @@
 #pragma once
 #include "../processor.h"
+#include "../kernel/envelope.h"
 
 namespace dsp::loop {
+    // Samples whose amplitude, envelope and gain are computed together by AGC
+    const int AGC_CHUNK = 256;
+
     template <class T>
     class AGC : public Processor<T, T> {
         using base_type = Processor<T, T>;
@@ -86,62 +90,59 @@ namespace dsp::loop {
         }
 
         inline int process(int count, T* in, T* out) {
-            for (int i = 0; i < count; i++) {
-                if (_enabled) {
-                    // Get signal amplitude
-                    float inAmp;
-                    if constexpr (std::is_same_v<T, complex_t>) {
-                        inAmp = in[i].amplitude();
+            // Largest amplitude up to the end of the block, only computed the first time something clips so that
+            // the block stays O(n) no matter how many impulses it holds
+            float* lookAhead = NULL;
+
+            // Work in chunks small enough for the amplitudes and gains to stay in cache between passes
+            float amps[AGC_CHUNK];
+            float gains[AGC_CHUNK];
+            for (int j = 0; j < count; j += AGC_CHUNK) {
+                int n = std::min<int>(AGC_CHUNK, count - j);
+                kernel::amplitude<T>(amps, &in[j], n);
+
+                if (!_enabled) {
+                    // Fixed gain, clipping to _maxOutputAmp
+                    for (int i = 0; i < n; i++) {
+                        gains[i] = (amps[i] * _gain > _maxOutputAmp) ? (_maxOutputAmp / amps[i]) : _gain;
                     }
-                    if constexpr (std::is_same_v<T, float>) {
-                        inAmp = fabsf(in[i]);
+                    kernel::scale<T>(&out[j], &in[j], gains, n);
+                    continue;
+                }
+
+                // Envelope, kept in gains until the gain itself is computed
+                for (int i = 0; i < n; i++) {
+                    float inAmp = amps[i];
+                    if (inAmp == 0.0f) {
+                        gains[i] = amp;
+                        continue;
                     }
-    
+
                     // Update average amplitude
-                    if (inAmp != 0.0f) {
-                        amp = (inAmp > amp) ? ((amp * _invAttack) + (inAmp * _attack)) : ((amp * _invDecay) + (inAmp * _decay));
-                        _gain = std::min<float>(_setPoint / amp, _maxGain);
-                    }
-                    else {
-                        _gain = 1.0f;
-                    }
-    
-                    // If clipping is detected look ahead and correct
-                    if (inAmp*_gain > _maxOutputAmp) {
-                        float maxAmp = 0;
-                        for (int j = i; j < count; j++) {
-                            if constexpr (std::is_same_v<T, complex_t>) {
-                                inAmp = in[j].amplitude();
-                            }
-                            if constexpr (std::is_same_v<T, float>) {
-                                inAmp = fabsf(in[j]);
-                            }
-                            if (inAmp > maxAmp) { maxAmp = inAmp; }
+                    amp = (inAmp > amp) ? ((amp * _invAttack) + (inAmp * _attack)) : ((amp * _invDecay) + (inAmp * _decay));
+
+                    // If clipping is detected look ahead and correct, inAmp * min(setPoint / amp, maxGain) > maxOutputAmp
+                    // being checked without dividing
+                    if (inAmp * _setPoint > _maxOutputAmp * amp && inAmp * _maxGain > _maxOutputAmp) {
+                        if (!lookAhead) {
+                            // Only from this chunk on, the previous ones may already have been overwritten
+                            lookAhead = lookAheadBuf.reserve(0, count);
+                            kernel::amplitude<T>(&lookAhead[j], &in[j], count - j);
+                            kernel::suffixMax(&lookAhead[j], &lookAhead[j], count - j);
                         }
-                        amp = maxAmp;
-                        _gain = std::min<float>(_setPoint / amp, _maxGain);
+                        amp = lookAhead[j + i];
                     }
+                    gains[i] = amp;
+                }
 
-                    // Scale output by gain
-                    out[i] = in[i] * _gain;
-                } else {
-                    // Get signal amplitude
-                    float inAmp;
-                    if constexpr (std::is_same_v<T, complex_t>) {
-                        inAmp = in[i].amplitude();
-                    }
-                    if constexpr (std::is_same_v<T, float>) {
-                        inAmp = fabsf(in[i]);
-                    }
-                    // Scale output by gain
-                    float gainAmp = inAmp*_gain;
-                    if (gainAmp > _maxOutputAmp) {
-                        // clipping to _maxOutputAmp
-                        out[i] = in[i] * (_maxOutputAmp/inAmp);
-                    } else {
-                        out[i] = in[i] * _gain;
-                    }
+                // Gain from the envelope, silent samples getting a unity gain
+                for (int i = 0; i < n; i++) {
+                    gains[i] = (amps[i] != 0.0f) ? std::min<float>(_setPoint / gains[i], _maxGain) : 1.0f;
                 }
+
+                // Scale output by gain
+                kernel::scale<T>(&out[j], &in[j], gains, n);
+                _gain = gains[n - 1];
             }
             return count;
         }
@@ -157,6 +158,8 @@ namespace dsp::loop {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         float _setPoint;
         float _attack;
@@ -171,5 +174,6 @@ namespace dsp::loop {
 
         float amp = 1.0;
 
+        buffer::WorkBuffer<float> lookAheadBuf;
     };
 }
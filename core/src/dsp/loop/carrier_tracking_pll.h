@@ -13,8 +13,8 @@ namespace dsp::loop {
 
         inline int process(int count, complex_t* in, complex_t* out) {
             for (int i = 0; i < count; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
-                pcl.advance(math::normalizePhase(in[i].phase() - pcl.phase));
+                out[i] = in[i] * math::fastPhasor(-pcl.phase);
+                pcl.advance(math::normalizePhase(math::polyAtan2<math::ATAN2_ACCURACY_HIGH>(in[i].im, in[i].re) - pcl.phase));
             }
             return count;
         }
@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "../kernel/envelope.h"
 
 namespace dsp::loop {
     template <class T>
@@ -58,23 +59,22 @@ namespace dsp::loop {
         }
 
         inline int process(int count, T* in, T* out) {
+            // The output amplitude is the input amplitude times the gain, so only the gain has to be run sample by
+            // sample and the square roots and the scaling are done on the whole block
+            float* amps = ampBuf.reserve(0, count);
+            float* gains = gainBuf.reserve(0, count);
+            kernel::amplitude<T>(amps, in, count);
+
             for (int i = 0; i < count; i++) {
-                // Output scaled input
-                out[i] = in[i] * _gain;
-
-                // Calculate output amplitude
-                float amp;
-                if constexpr (std::is_same_v<T, float>) {
-                    amp = fabsf(out[i]);
-                }
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    amp = out[i].amplitude();
-                }
+                gains[i] = _gain;
 
                 // Update and clamp gain
-                _gain += (_setPoint - amp) * _rate;
+                _gain += (_setPoint - amps[i] * fabsf(_gain)) * _rate;
                 if (_gain > _maxGain) { _gain = _maxGain; }
             }
+
+            // Output scaled input
+            kernel::scale<T>(out, in, gains, count);
             return count;
         }
 
@@ -89,6 +89,8 @@ namespace dsp::loop {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         float _gain;
         float _setPoint;
@@ -96,5 +98,7 @@ namespace dsp::loop {
         float _maxGain;
         float _initGain;
 
+        buffer::WorkBuffer<float> ampBuf;
+        buffer::WorkBuffer<float> gainBuf;
     };
 }
\ No newline at end of file
@@ -70,6 +70,14 @@ namespace dsp::loop {
             if constexpr(CLAMP_PHASE) { clampPhase(); }
         }
 
+        // Same as calling advancePhase() count times, up to rounding
+        inline void advancePhase(int count) {
+            phase += freq * (T)count;
+            if constexpr(CLAMP_PHASE) {
+                if (phase > _maxPhase || phase < _minPhase) { phase -= phaseDelta * floor((phase - _minPhase) / phaseDelta); }
+            }
+        }
+
         T freq;
         T phase;
 
@@ -2,6 +2,7 @@
 #include "../processor.h"
 #include "../math/normalize_phase.h"
 #include "../math/phasor.h"
+#include "../math/fast_atan2.h"
 #include "phase_control_loop.h"
 
 namespace dsp::loop {
@@ -63,8 +64,8 @@ namespace dsp::loop {
 
         virtual inline int process(int count, complex_t* in, complex_t* out) {
             for (int i = 0; i < count; i++) {
-                out[i] = math::phasor(pcl.phase);
-                pcl.advance(math::normalizePhase(in[i].phase() - pcl.phase));
+                out[i] = math::fastPhasor(pcl.phase);
+                pcl.advance(math::normalizePhase(math::polyAtan2<math::ATAN2_ACCURACY_HIGH>(in[i].im, in[i].re) - pcl.phase));
             }
             return count;
         }
@@ -80,6 +81,8 @@ namespace dsp::loop {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         PhaseControlLoop<float> pcl;
         float _initPhase;
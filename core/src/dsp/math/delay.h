@@ -13,13 +13,12 @@ namespace dsp::math {
         ~Delay() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
         }
 
         void init(stream<T>* in, int delay) {
             _delay = delay;
 
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
+            buffer = work.reserve(0, _delay + buffer::WORK_BUFFER_INITIAL_SIZE);
             bufStart = &buffer[_delay];
             buffer::clear(buffer, _delay);
 
@@ -31,6 +30,7 @@ namespace dsp::math {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             _delay = delay;
+            buffer = work.reserve(0, _delay);
             bufStart = &buffer[_delay];
             reset();
             base_type::tempStart();
@@ -46,6 +46,8 @@ namespace dsp::math {
 
         inline int process(int count, const T* in, T* out) {
             // Copy data into delay buffer
+            buffer = work.reserve(_delay, count);
+            bufStart = &buffer[_delay];
             memcpy(bufStart, in, count * sizeof(T));
 
             // Copy data out of the delay buffer
@@ -68,8 +70,11 @@ namespace dsp::math {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         int _delay;
+        buffer::WorkBuffer<T> work;
         T* buffer;
         T* bufStart;
     };
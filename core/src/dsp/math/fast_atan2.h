@@ -1,5 +1,7 @@
 #pragma once
 #include <math.h>
+#include <float.h>
+#include <algorithm>
 #include "constants.h"
 
 #define FAST_ATAN2_COEF1 FL_M_PI / 4.0f
@@ -23,4 +25,43 @@ namespace dsp::math {
         }
         return angle;
     }
-}
\ No newline at end of file
+
+    // Accuracy of polyAtan2(), the maximum error is given in radians
+    enum Atan2Accuracy {
+        ATAN2_ACCURACY_LOW,         // 5e-3, 2 coefficients
+        ATAN2_ACCURACY_MEDIUM,      // 1.2e-5, 5 coefficients
+        ATAN2_ACCURACY_HIGH,        // 2e-6, 6 coefficients
+        ATAN2_ACCURACY_EXACT        // atan2f() itself
+    };
+
+    // atan2(y, x) from a minimax polynomial approximation of the arctangent over [0, 1], folded out to the other octants.
+    // There are no branches, only selects, so that loops calling it get vectorized.
+    template <Atan2Accuracy ACCURACY>
+    inline float polyAtan2(float y, float x) {
+        if constexpr (ACCURACY == ATAN2_ACCURACY_EXACT) {
+            return atan2f(y, x);
+        }
+        else {
+            // Ratio of the smaller to the larger component, zero for a zero input
+            float ax = fabsf(x);
+            float ay = fabsf(y);
+            float a = std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN);
+            float s = a * a;
+
+            float r;
+            if constexpr (ACCURACY == ATAN2_ACCURACY_LOW) {
+                r = a * (0.97239411f - 0.19194795f * s);
+            }
+            else if constexpr (ACCURACY == ATAN2_ACCURACY_MEDIUM) {
+                r = a * (0.99986633f + s * (-0.33030479f + s * (0.18015929f + s * (-0.08515635f + 0.02084511f * s))));
+            }
+            else {
+                r = a * (0.99997722f + s * (-0.33262283f + s * (0.19354038f + s * (-0.11642649f + s * (0.05264735f - 0.01171914f * s)))));
+            }
+
+            r = (ay > ax) ? (FL_M_PI / 2.0f) - r : r;
+            r = (x < 0.0f) ? FL_M_PI - r : r;
+            return (y < 0.0f) ? -r : r;
+        }
+    }
+}
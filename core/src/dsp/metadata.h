@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+namespace dsp {
+    enum TagType {
+        TAG_RETUNE,             // Value is the new frequency in Hz
+        TAG_GAIN_CHANGE,        // Value is the new gain, in the source's own unit
+        TAG_SAMPLERATE_CHANGE,  // Value is the new samplerate in S/s
+        TAG_USER
+    };
+
+    struct Tag {
+        int offset;             // Sample of the block the event applies from
+        TagType type;
+        double value;
+    };
+
+    // Side channel describing the block of samples it travels with. Writers that don't know about it leave it
+    // invalid, blocks that don't know how their output relates to their input don't carry it over.
+    struct Metadata {
+        static const int MAX_TAGS = 8;
+
+        bool valid = false;
+        uint64_t sampleIndex = 0;   // Index of the first sample of the block, counted at the block's samplerate
+        int64_t timestamp = 0;      // Capture time of the first sample of the block in nanoseconds since the epoch
+        double samplerate = 0.0;
+        int tagCount = 0;
+        Tag tags[MAX_TAGS];
+
+        inline void clear() {
+            valid = false;
+            tagCount = 0;
+        }
+
+        // Tags are dropped once there are too many of them in a single block
+        inline void addTag(TagType type, double value, int offset = 0) {
+            if (tagCount >= MAX_TAGS) { return; }
+            tags[tagCount++] = Tag{ offset, type, value };
+        }
+
+        // Take over the description of another block, tags still pending here because no block went out are kept
+        inline void update(const Metadata& meta) {
+            valid = meta.valid;
+            sampleIndex = meta.sampleIndex;
+            timestamp = meta.timestamp;
+            samplerate = meta.samplerate;
+            for (int i = 0; i < tagCount; i++) { tags[i].offset = 0; }
+            for (int i = 0; i < meta.tagCount; i++) { addTag(meta.tags[i].type, meta.tags[i].value, meta.tags[i].offset); }
+        }
+
+        // Describe the output of a resampler by interp/decim whose first output sample lies position / interp
+        // input samples into the block
+        inline void resample(int interp, int decim, int64_t position) {
+            sampleIndex = (sampleIndex * interp + position) / decim;
+            if (samplerate > 0.0) { timestamp += (int64_t)((double)position / (double)interp / samplerate * 1e9); }
+            samplerate = samplerate * (double)interp / (double)decim;
+
+            // Tags move to the first output sample at or after them
+            for (int i = 0; i < tagCount; i++) {
+                int64_t pos = (int64_t)tags[i].offset * interp - position;
+                tags[i].offset = (pos > 0) ? (int)((pos + decim - 1) / decim) : 0;
+            }
+        }
+
+        // Same for a resampler giving ratio output samples per input sample, whose first output sample lies
+        // position input samples into the block
+        inline void resample(double ratio, double position) {
+            sampleIndex = (uint64_t)(((double)sampleIndex + position) * ratio);
+            if (samplerate > 0.0) { timestamp += (int64_t)(position / samplerate * 1e9); }
+            samplerate = samplerate * ratio;
+
+            for (int i = 0; i < tagCount; i++) {
+                double pos = ((double)tags[i].offset - position) * ratio;
+                tags[i].offset = (pos > 0.0) ? (int)ceil(pos) : 0;
+            }
+        }
+    };
+
+    // Stamps the blocks written by a source. Tags can be added from any thread, they go out with the next block.
+    class MetadataStamper {
+    public:
+        void start(double samplerate) {
+            std::lock_guard<std::mutex> lck(tagMtx);
+            _samplerate = samplerate;
+            sampleIndex = 0;
+            pending.clear();
+            pendingCount = 0;
+        }
+
+        void addTag(TagType type, double value) {
+            std::lock_guard<std::mutex> lck(tagMtx);
+            pending.push_back(Tag{ 0, type, value });
+            pendingCount = pending.size();
+        }
+
+        // To be called by the writer before swapping a block of count samples that was just received
+        void stamp(Metadata& meta, int count) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            meta.valid = true;
+            meta.sampleIndex = sampleIndex;
+            meta.samplerate = _samplerate;
+            meta.timestamp = (_samplerate > 0.0) ? (now - (int64_t)((double)count / _samplerate * 1e9)) : now;
+            sampleIndex += count;
+
+            // Only take the lock if there's something to hand over
+            if (!pendingCount) { return; }
+            std::lock_guard<std::mutex> lck(tagMtx);
+            for (const auto& tag : pending) { meta.addTag(tag.type, tag.value); }
+            pending.clear();
+            pendingCount = 0;
+        }
+
+    private:
+        double _samplerate = 0.0;
+        uint64_t sampleIndex = 0;
+        std::mutex tagMtx;
+        std::vector<Tag> pending;
+        std::atomic<int> pendingCount = 0;
+    };
+}
@@ -44,7 +44,7 @@ namespace dsp::mod {
         inline int process(int count, const float* in, complex_t* out) {
             for (int i = 0; i < count; i++) {
                 phase = math::normalizePhase(phase + (_deviation * in[i]));
-                out[i] = math::phasor(phase);
+                out[i] = math::fastPhasor(phase);
             }
             return count;
         }
@@ -60,6 +60,8 @@ namespace dsp::mod {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         float _deviation;
         float phase = 0.0f;
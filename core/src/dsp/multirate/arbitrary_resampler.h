@@ -0,0 +1,196 @@
+#pragma once
+#include <atomic>
+#include <algorithm>
+#include "../processor.h"
+#include "../taps/windowed_sinc.h"
+#include "../taps/estimate_tap_count.h"
+#include "../kernel/dot_prod.h"
+
+namespace dsp::multirate {
+    // Branches of the interpolation filter, outputs falling between two of them use taps interpolated between both
+    const int ARBITRARY_RESAMPLER_PHASES = 128;
+
+    // Largest relative rate correction accepted by setRateCorrection()
+    const double ARBITRARY_RESAMPLER_MAX_CORRECTION = 0.01;
+
+    // Resampler for any ratio of samplerates, including those whose rational form would need thousands of phases.
+    // The position of each output is tracked as a fraction of an input sample and the filter for that fraction is
+    // linearly interpolated between the two nearest of a fixed number of polyphase branches, so memory and work per
+    // output only depend on the filter's length, never on the ratio itself.
+    template<class T>
+    class ArbitraryResampler : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        ArbitraryResampler() {}
+
+        ArbitraryResampler(stream<T>* in, double inSamplerate, double outSamplerate) { init(in, inSamplerate, outSamplerate); }
+
+        ~ArbitraryResampler() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+        }
+
+        void init(stream<T>* in, double inSamplerate, double outSamplerate) {
+            _inSamplerate = inSamplerate;
+            _outSamplerate = outSamplerate;
+            buildBranches();
+
+            // Allocate delay buffer, it grows later on if given larger blocks
+            buffer = work.reserve(0, tapsPerPhase - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
+            buffer::clear<T>(buffer, tapsPerPhase - 1);
+
+            base_type::init(in);
+        }
+
+        void setRates(double inSamplerate, double outSamplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _inSamplerate = inSamplerate;
+            _outSamplerate = outSamplerate;
+            buildBranches();
+            buffer = work.reserve(0, tapsPerPhase - 1);
+            reset();
+            base_type::tempStart();
+        }
+
+        // Scale the output samplerate by (1 + correction) without rebuilding the filter or stopping the block,
+        // meant for following a slowly drifting clock. The correction is clamped to ARBITRARY_RESAMPLER_MAX_CORRECTION.
+        void setRateCorrection(double correction) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _correction = std::clamp<double>(correction, -ARBITRARY_RESAMPLER_MAX_CORRECTION, ARBITRARY_RESAMPLER_MAX_CORRECTION);
+            step = _inSamplerate / (_outSamplerate * (1.0 + _correction));
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            buffer::clear<T>(buffer, tapsPerPhase - 1);
+            offset = 0;
+            frac = 0.0;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            // Copy data after the history
+            buffer = work.reserve(tapsPerPhase - 1, count);
+            memcpy(&buffer[tapsPerPhase - 1], in, count * sizeof(T));
+
+            // The step is read once so that a correction coming in mid-block doesn't change the output count
+            constexpr int channels = std::is_same_v<T, float> ? 1 : 2;
+            double inc = step.load();
+            int outCount = 0;
+            while (offset < count) {
+                // Branch just before the output's position and how far towards the next one it lies
+                double pos = frac * (double)ARBITRARY_RESAMPLER_PHASES;
+                int p = (int)pos;
+                float mu = (float)(pos - (double)p);
+
+                float a[channels];
+                float d[channels];
+                kernel::dotProdBlock<channels, 1>(a, 0, (const float*)&buffer[offset], 0, NULL, branches[p]);
+                kernel::dotProdBlock<channels, 1>(d, 0, (const float*)&buffer[offset], 0, NULL, slopes[p]);
+                float* o = (float*)&out[outCount++];
+                for (int c = 0; c < channels; c++) { o[c] = a[c] + mu * d[c]; }
+
+                // Advance by the step, carrying whole samples over to the offset
+                frac += inc;
+                int whole = (int)frac;
+                offset += whole;
+                frac -= (double)whole;
+            }
+            offset -= count;
+
+            // Move delay
+            memmove(buffer, &buffer[count], (tapsPerPhase - 1) * sizeof(T));
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+        int maxOutputSize(int count) {
+            // Leave room for the largest correction since it can change between now and the pass
+            double ratio = _outSamplerate * (1.0 + ARBITRARY_RESAMPLER_MAX_CORRECTION) / _inSamplerate;
+            return (int)ceil((double)count * ratio) + 1;
+        }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // The first output is taken offset + frac samples into the block
+            Metadata meta = in;
+            meta.resample(1.0 / step.load(), (double)offset + frac);
+            out.update(meta);
+        }
+
+        int getTapsPerPhase() {
+            return tapsPerPhase;
+        }
+
+    protected:
+        // The prototype filter runs at ARBITRARY_RESAMPLER_PHASES times the input samplerate with the same cutoff and
+        // transition as RationalResampler's. Branch p, tap i holds the prototype at (tapsPerPhase - 1 - i) input samples
+        // plus p phases, and its slope the step to the following phase, the one after the last tap being zero.
+        void buildBranches() {
+            constexpr int channels = std::is_same_v<T, float> ? 1 : 2;
+            const int phases = ARBITRARY_RESAMPLER_PHASES;
+            double bandwidth = std::min<double>(_inSamplerate, _outSamplerate) / 2.0;
+            double transWidth = bandwidth * 0.1;
+
+            // Round up to whole lanes so that the dot products never leave the vectorized loop
+            int lanes = kernel::DOT_PROD_LANES / channels;
+            tapsPerPhase = std::max<int>(taps::estimateTapCount(transWidth, _inSamplerate), 1);
+            tapsPerPhase = ((tapsPerPhase + lanes - 1) / lanes) * lanes;
+
+            int count = tapsPerPhase * phases;
+            tap<float> proto = taps::windowedSinc<float>(count, bandwidth, _inSamplerate * (double)phases, window::nuttall, phases);
+
+            branches.resize(phases);
+            slopes.resize(phases);
+            std::vector<float> branch(tapsPerPhase);
+            std::vector<float> slope(tapsPerPhase);
+            for (int p = 0; p < phases; p++) {
+                for (int i = 0; i < tapsPerPhase; i++) {
+                    int id = (tapsPerPhase - 1 - i) * phases + p;
+                    float next = (id + 1 < count) ? proto.taps[id + 1] : 0.0f;
+                    branch[i] = proto.taps[id];
+                    slope[i] = next - proto.taps[id];
+                }
+                branches[p].init(branch.data(), tapsPerPhase, channels, false);
+                slopes[p].init(slope.data(), tapsPerPhase, channels, false);
+            }
+            taps::free(proto);
+
+            step = _inSamplerate / (_outSamplerate * (1.0 + _correction));
+        }
+
+        double _inSamplerate;
+        double _outSamplerate;
+        double _correction = 0.0;
+
+        // Input samples per output
+        std::atomic<double> step = 1.0;
+
+        int tapsPerPhase;
+        std::vector<kernel::TapLanes> branches;
+        std::vector<kernel::TapLanes> slopes;
+
+        int offset = 0;
+        double frac = 0.0;
+        buffer::WorkBuffer<T> work;
+        T* buffer;
+    };
+}
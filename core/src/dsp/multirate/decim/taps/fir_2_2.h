@@ -1,81 +1,124 @@
 #pragma once
 
 /*
-    This file was auto-generated by the magic optimized FIR script.
+    Equiripple half-band filter, flat up to 0.222 of the samplerate and 103 dB down from 0.278.
+    Every other tap is exactly zero so that the decimator can skip them.
     DO NOT EDIT MANUALLY!!!
 */
 
 namespace dsp::multirate::decim {
-    const unsigned int fir_2_2_len = 69;
+    const unsigned int fir_2_2_len = 111;
     const float fir_2_2_taps[] = {
-        0.000400633624864,
-        0.002075598505552,
-        0.004856364956715,
-        0.005979016698235,
-        0.002622922607902,
-        -0.002718259152577,
-        -0.003381533671376,
-        0.001638638539759,
-        0.004081814705993,
-        -0.000984029228217,
-        -0.005120988470135,
-        0.000177440907285,
-        0.006425852662023,
-        0.001009351602305,
-        -0.007912827910006,
-        -0.002713700675199,
-        0.009509311257450,
-        0.005070635723474,
-        -0.011154020477109,
-        -0.008246059919867,
-        0.012785716787299,
-        0.012487906837156,
-        -0.014347452386709,
-        -0.018205770848481,
-        0.015781858576801,
-        0.026172374716730,
-        -0.017037643409603,
-        -0.038051489304887,
-        0.018067070624730,
-        0.058212412671604,
-        -0.018832304184135,
-        -0.102772486604899,
-        0.019303165035556,
-        0.317189488733641,
-        0.480537520090363,
-        0.317189488733641,
-        0.019303165035556,
-        -0.102772486604899,
-        -0.018832304184135,
-        0.058212412671604,
-        0.018067070624730,
-        -0.038051489304887,
-        -0.017037643409603,
-        0.026172374716730,
-        0.015781858576801,
-        -0.018205770848481,
-        -0.014347452386709,
-        0.012487906837156,
-        0.012785716787299,
-        -0.008246059919867,
-        -0.011154020477109,
-        0.005070635723474,
-        0.009509311257450,
-        -0.002713700675199,
-        -0.007912827910006,
-        0.001009351602305,
-        0.006425852662023,
-        0.000177440907285,
-        -0.005120988470135,
-        -0.000984029228217,
-        0.004081814705993,
-        0.001638638539759,
-        -0.003381533671376,
-        -0.002718259152577,
-        0.002622922607902,
-        0.005979016698235,
-        0.004856364956715,
-        0.002075598505552,
-        0.000400633624864,
+        -0.000010405540826,
+        0.000000000000000,
+        0.000021561600844,
+        0.000000000000000,
+        -0.000043037186382,
+        0.000000000000000,
+        0.000077642523824,
+        0.000000000000000,
+        -0.000130582312112,
+        0.000000000000000,
+        0.000208330716888,
+        0.000000000000000,
+        -0.000318761377291,
+        0.000000000000000,
+        0.000471280828799,
+        0.000000000000000,
+        -0.000676952460127,
+        0.000000000000000,
+        0.000948633676328,
+        0.000000000000000,
+        -0.001301141388969,
+        0.000000000000000,
+        0.001751476842281,
+        0.000000000000000,
+        -0.002319175665696,
+        0.000000000000000,
+        0.003026853565165,
+        0.000000000000000,
+        -0.003901088369556,
+        0.000000000000000,
+        0.004973855324383,
+        0.000000000000000,
+        -0.006284864796489,
+        0.000000000000000,
+        0.007885434421711,
+        0.000000000000000,
+        -0.009845023471089,
+        0.000000000000000,
+        0.012262611149414,
+        0.000000000000000,
+        -0.015287422229428,
+        0.000000000000000,
+        0.019159004926117,
+        0.000000000000000,
+        -0.024291216334301,
+        0.000000000000000,
+        0.031468306831677,
+        0.000000000000000,
+        -0.042377127430290,
+        0.000000000000000,
+        0.061416369807295,
+        0.000000000000000,
+        -0.104741961718768,
+        0.000000000000000,
+        0.317853758118517,
+        0.500000000000000,
+        0.317853758118517,
+        0.000000000000000,
+        -0.104741961718768,
+        0.000000000000000,
+        0.061416369807295,
+        0.000000000000000,
+        -0.042377127430290,
+        0.000000000000000,
+        0.031468306831677,
+        0.000000000000000,
+        -0.024291216334301,
+        0.000000000000000,
+        0.019159004926117,
+        0.000000000000000,
+        -0.015287422229428,
+        0.000000000000000,
+        0.012262611149414,
+        0.000000000000000,
+        -0.009845023471089,
+        0.000000000000000,
+        0.007885434421711,
+        0.000000000000000,
+        -0.006284864796489,
+        0.000000000000000,
+        0.004973855324383,
+        0.000000000000000,
+        -0.003901088369556,
+        0.000000000000000,
+        0.003026853565165,
+        0.000000000000000,
+        -0.002319175665696,
+        0.000000000000000,
+        0.001751476842281,
+        0.000000000000000,
+        -0.001301141388969,
+        0.000000000000000,
+        0.000948633676328,
+        0.000000000000000,
+        -0.000676952460127,
+        0.000000000000000,
+        0.000471280828799,
+        0.000000000000000,
+        -0.000318761377291,
+        0.000000000000000,
+        0.000208330716888,
+        0.000000000000000,
+        -0.000130582312112,
+        0.000000000000000,
+        0.000077642523824,
+        0.000000000000000,
+        -0.000043037186382,
+        0.000000000000000,
+        0.000021561600844,
+        0.000000000000000,
+        -0.000010405540826,
     };
 }
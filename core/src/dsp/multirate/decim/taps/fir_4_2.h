@@ -1,24 +1,32 @@
 #pragma once
 
 /*
-    This file was auto-generated by the magic optimized FIR script.
+    Equiripple half-band filter, flat up to 0.111 of the samplerate and 100 dB down from 0.389.
+    Every other tap is exactly zero so that the decimator can skip them.
     DO NOT EDIT MANUALLY!!!
 */
 
 namespace dsp::multirate::decim {
-    const unsigned int fir_4_2_len = 12;
+    const unsigned int fir_4_2_len = 19;
     const float fir_4_2_taps[] = {
-        -0.003856211869499,
-        -0.022330421420748,
-        -0.042348797151517,
-        0.009330574289172,
-        0.182544215014523,
-        0.363014696342451,
-        0.363014696342451,
-        0.182544215014523,
-        0.009330574289172,
-        -0.042348797151517,
-        -0.022330421420748,
-        -0.003856211869499,
+        0.000821649338822,
+        0.000000000000000,
+        -0.005973610822335,
+        0.000000000000000,
+        0.024059952648917,
+        0.000000000000000,
+        -0.075659741438700,
+        0.000000000000000,
+        0.306756749586633,
+        0.500000000000000,
+        0.306756749586633,
+        0.000000000000000,
+        -0.075659741438700,
+        0.000000000000000,
+        0.024059952648917,
+        0.000000000000000,
+        -0.005973610822335,
+        0.000000000000000,
+        0.000821649338822,
     };
 }
@@ -1,7 +1,10 @@
 #pragma once
+#include <numeric>
 #include "../processor.h"
 #include "../taps/tap.h"
 #include "polyphase_bank.h"
+#include "../kernel/symmetric.h"
+#include "../kernel/dot_prod.h"
 
 namespace dsp::multirate {
     template<class T>
@@ -15,7 +18,6 @@ namespace dsp::multirate {
         ~PolyphaseResampler() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
             freePolyphaseBank(phases);
         }
 
@@ -26,9 +28,10 @@ namespace dsp::multirate {
 
             // Build filter bank
             phases = buildPolyphaseBank(_interp, _taps);
+            buildPhaseLanes();
 
-            // Allocate delay buffer
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
+            // Allocate delay buffer, it grows later on if given larger blocks
+            buffer = work.reserve(0, phases.tapsPerPhase - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
             bufStart = &buffer[phases.tapsPerPhase - 1];
             buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
 
@@ -48,8 +51,10 @@ namespace dsp::multirate {
             // Re-generate polyphase bank
             freePolyphaseBank(phases);
             phases = buildPolyphaseBank(_interp, _taps);
+            buildPhaseLanes();
 
             // Reset buffer
+            buffer = work.reserve(0, phases.tapsPerPhase - 1);
             bufStart = &buffer[phases.tapsPerPhase - 1];
             reset();
 
@@ -70,16 +75,42 @@ namespace dsp::multirate {
             int outCount = 0;
 
             // Copy input to buffer
+            buffer = work.reserve(phases.tapsPerPhase - 1, count);
+            bufStart = &buffer[phases.tapsPerPhase - 1];
             memcpy(bufStart, in, count * sizeof(T));
 
-            while (offset < count) {
+            // Reversed copy of the buffer for the phases that can use the folded kernel
+            T* mirror = NULL;
+            if (symmetricCount) {
+                int len = count + phases.tapsPerPhase - 1;
+                mirror = mirrorBuf.reserve(0, len);
+                std::reverse_copy(buffer, &buffer[len], mirror);
+            }
+
+            // The phases repeat every period outputs, during which the input moves forward by advance samples.
+            // Outputs sharing a phase are then evenly spaced and get computed together.
+            int g = std::gcd(_interp, _decim);
+            int period = _interp / g;
+            int advance = _decim / g;
+
+            // Count the outputs of the block
+            int endPhase = phase;
+            int endOffset = offset;
+            while (endOffset < count) {
+                outCount++;
+                endPhase += _decim;
+                endOffset += endPhase / _interp;
+                endPhase = endPhase % _interp;
+            }
+
+            constexpr int channels = std::is_same_v<T, float> ? 1 : 2;
+            int groups = std::min<int>(period, outCount);
+            for (int i = 0; i < groups; i++) {
                 // Do convolution
-                if constexpr (std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &buffer[offset], phases.phases[phase], phases.tapsPerPhase);
-                }
-                if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&buffer[offset], phases.phases[phase], phases.tapsPerPhase);
-                }
+                const kernel::TapLanes& taps = phaseLanes[phase];
+                int n = (outCount - i + period - 1) / period;
+                const float* m = taps.folded ? (const float*)&mirror[count - 1 - offset] : NULL;
+                kernel::stridedDotProd<channels>((float*)&out[i], period, n, (const float*)&buffer[offset], advance, m, taps);
 
                 // Increment phase
                 phase += _decim;
@@ -90,6 +121,8 @@ namespace dsp::multirate {
                 // Wrap around if needed
                 phase = phase % _interp;
             }
+            phase = endPhase;
+            offset = endOffset;
             offset -= count;
 
             // Move delay
@@ -112,13 +145,42 @@ namespace dsp::multirate {
             return outCount;
         }
 
+        int maxOutputSize(int count) {
+            // Each input sample gives at most interp/decim outputs, plus one for the phase carried over
+            return (int)(((int64_t)count * _interp + _decim - 1) / _decim) + 1;
+        }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // The first output is taken offset samples and phase / interp of a sample into the block
+            Metadata meta = in;
+            meta.resample(_interp, _decim, (int64_t)offset * _interp + phase);
+            out.update(meta);
+        }
+
     protected:
+        // Phases of a symmetric filter aren't symmetric themselves except for the middle one when there's
+        // one, or all of them when not interpolating. Only those can use the folded kernel.
+        void buildPhaseLanes() {
+            constexpr int channels = std::is_same_v<T, float> ? 1 : 2;
+            phaseLanes.resize(phases.phaseCount);
+            symmetricCount = 0;
+            for (int i = 0; i < phases.phaseCount; i++) {
+                bool symmetric = kernel::isSymmetric(phases.phases[i], phases.tapsPerPhase);
+                phaseLanes[i].init(phases.phases[i], phases.tapsPerPhase, channels, symmetric);
+                if (symmetric) { symmetricCount++; }
+            }
+        }
+
         int _interp;
         int _decim;
         tap<float> _taps;
         PolyphaseBank<float> phases;
         int phase = 0;
         int offset = 0;
+        buffer::WorkBuffer<T> work;
+        buffer::WorkBuffer<T> mirrorBuf;
+        std::vector<kernel::TapLanes> phaseLanes;
+        int symmetricCount = 0;
         T* buffer;
         T* bufStart;
 
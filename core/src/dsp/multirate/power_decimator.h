@@ -80,6 +80,19 @@ namespace dsp::multirate {
             return outCount;
         }
 
+        int maxOutputSize(int count) { return count; }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            // Go through the stages the same way the samples do
+            Metadata meta = in;
+            for (auto& fir : decimFirs) {
+                Metadata stage;
+                fir->mapMetadata(meta, stage);
+                meta = stage;
+            }
+            out.update(meta);
+        }
+
     protected:
         void freeFirs() {
             for (auto& fir : decimFirs) { delete fir; }
@@ -98,6 +111,7 @@ namespace dsp::multirate {
                 decim::plan plan = decim::plans[planId];
                 stageCount = plan.stageCount;
                 for (int i = 0; i < stageCount; i++) {
+                    // Decimate by 2 stages are half-band designs, the FIR runs them with a dedicated kernel that skips their zero taps
                     tap<float> taps = taps::fromArray<float>(plan.stages[i].tapcount, plan.stages[i].taps);
                     auto fir = new filter::DecimatingFIR<T, float>(NULL, taps, plan.stages[i].decimation);
                     fir->out.free();
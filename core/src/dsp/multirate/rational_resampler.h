@@ -5,12 +5,20 @@
 #include "../filter/decimating_fir.h"
 #include "../taps/from_array.h"
 #include "polyphase_resampler.h"
+#include "arbitrary_resampler.h"
 #include "power_decimator.h"
 #include "../taps/low_pass.h"
 #include "../window/nuttall.h"
 #include "utils/flog.h"
 
 namespace dsp::multirate {
+    // Past this many phases the polyphase bank of a rational ratio takes more memory than the arbitrary resampler's
+    // branches and slopes together, so despite its single dot product per output the arbitrary resampler is used
+    const int RATIONAL_RESAMPLER_MAX_INTERP = 2 * ARBITRARY_RESAMPLER_PHASES;
+
+    // Relative error in percent allowed by rounding the samplerates to integers before the arbitrary resampler is used
+    const double RATIONAL_RESAMPLER_MAX_ERROR = 0.01;
+
     template<class T>
     class RationalResampler : public Processor<T, T> {
         using base_type = Processor<T, T>;
@@ -33,9 +41,11 @@ namespace dsp::multirate {
             rtaps = taps::lowPass(0.25, 0.1, 1.0);
             decim.init(NULL, 2);
             resamp.init(NULL, 1, 1, rtaps);
+            arbResamp.init(NULL, 2.0, 1.0);
 
             decim.out.free();
             resamp.out.free();
+            arbResamp.out.free();
 
             // Proper configuration
             reconfigure();
@@ -49,6 +59,7 @@ namespace dsp::multirate {
             base_type::tempStop();
             decim.reset();
             resamp.reset();
+            arbResamp.reset();
             base_type::tempStart();
         }
 
@@ -80,15 +91,30 @@ namespace dsp::multirate {
             base_type::tempStart();
         }
 
+        // Scale the output samplerate by (1 + correction) to follow a slowly drifting clock. This switches over
+        // to the arbitrary resampler if needed, after which further corrections are applied without stopping.
+        void setRateCorrection(double correction) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _correction = correction;
+            if (arbitrary || _correction == 0.0) {
+                arbResamp.setRateCorrection(_correction);
+                return;
+            }
+            base_type::tempStop();
+            reconfigure();
+            base_type::tempStart();
+        }
+
         inline int process(int count, const T* in, T* out) {
             switch(mode) {
                 case Mode::BOTH:
                     count = decim.process(count, in, out);
-                    return resamp.process(count, out, out);
+                    return resample(count, out, out);
                 case Mode::DECIM_ONLY:
                     return decim.process(count, in, out);
                 case Mode::RESAMP_ONLY:
-                    return resamp.process(count, in, out);
+                    return resample(count, in, out);
                 case Mode::NONE:
                     memcpy(out, in, count * sizeof(T));
                     return count;
@@ -110,6 +136,38 @@ namespace dsp::multirate {
             return outCount;
         }
 
+        int maxOutputSize(int count) {
+            // The power decimator never outputs more than it's given and the resampler works in place
+            switch(mode) {
+                case Mode::BOTH:
+                case Mode::RESAMP_ONLY:
+                    return std::max<int>(count, arbitrary ? arbResamp.maxOutputSize(count) : resamp.maxOutputSize(count));
+                default:
+                    return count;
+            }
+        }
+
+        void mapMetadata(const Metadata& in, Metadata& out) {
+            Metadata meta;
+            switch(mode) {
+                case Mode::BOTH:
+                    decim.mapMetadata(in, meta);
+                    if (arbitrary) { arbResamp.mapMetadata(meta, out); }
+                    else { resamp.mapMetadata(meta, out); }
+                    return;
+                case Mode::DECIM_ONLY:
+                    decim.mapMetadata(in, out);
+                    return;
+                case Mode::RESAMP_ONLY:
+                    if (arbitrary) { arbResamp.mapMetadata(in, out); }
+                    else { resamp.mapMetadata(in, out); }
+                    return;
+                case Mode::NONE:
+                    out.update(in);
+                    return;
+            }
+        }
+
     protected:
         enum Mode {
             BOTH,
@@ -118,6 +176,11 @@ namespace dsp::multirate {
             NONE
         };
 
+        inline int resample(int count, const T* in, T* out) {
+            if (arbitrary) { return arbResamp.process(count, in, out); }
+            return resamp.process(count, in, out);
+        }
+
         void reconfigure() {
             // Calculate highest power-of-two decimation for the power decimator 
             int predecPower = std::min<int>(floor(log2(_inSamplerate / _outSamplerate)), PowerDecimator<T>::getMaxRatio());
@@ -141,16 +204,24 @@ namespace dsp::multirate {
             // Check for excessive error
             double actualOutSR = (double)IntSR * (double)interp / (double)decim;
             double error = abs((actualOutSR - _outSamplerate) / _outSamplerate) * 100.0;
-            if (error > 0.01) {
-                fprintf(stderr, "Warning: resampling error is over 0.01%%: %lf\n", error);
-            }
-            
+
             // If the power decimator already did all the work, don't use the resampler
-            if (interp == decim) {
+            if (interp == decim && _correction == 0.0) {
+                arbitrary = false;
                 mode = useDecim ? Mode::DECIM_ONLY : Mode::NONE;
                 return;
             }
 
+            // Ratios that are inexact, need too many phases or have to follow a clock go to the arbitrary resampler
+            arbitrary = (interp > RATIONAL_RESAMPLER_MAX_INTERP || error > RATIONAL_RESAMPLER_MAX_ERROR || _correction != 0.0);
+            if (arbitrary) {
+                arbResamp.setRates(intSamplerate, _outSamplerate);
+                arbResamp.setRateCorrection(_correction);
+                flog::debug("[Resamp] predec: {}, arbitrary ratio: {}, taps per phase: {}", predecRatio, _outSamplerate / intSamplerate, arbResamp.getTapsPerPhase());
+                mode = useDecim ? Mode::BOTH : Mode::RESAMP_ONLY;
+                return;
+            }
+
             // Configure the polyphase resampler
             double tapSamplerate = intSamplerate * (double)interp;
             double tapBandwidth = std::min<double>(_inSamplerate, _outSamplerate) / 2.0;
@@ -168,9 +239,12 @@ namespace dsp::multirate {
         
         PowerDecimator<T> decim;
         PolyphaseResampler<T> resamp;
+        ArbitraryResampler<T> arbResamp;
         tap<float> rtaps;
         double _inSamplerate;
         double _outSamplerate;
+        double _correction = 0.0;
+        bool arbitrary = false;
         Mode mode;
     };
 }
\ No newline at end of file
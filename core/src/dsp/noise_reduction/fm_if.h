@@ -4,12 +4,16 @@
 #include <fftw3.h>
 
 namespace dsp::noise_reduction {
+    // Keeps only the strongest bin of the spectrum of the last bins samples, as seen from the middle of that window.
+    // The strongest bin is searched for every hop samples with an FFT, in between the output is the windowed DFT of
+    // that same bin, which is a single dot product. A hop of 1 searches at every sample, larger hops trade how fast
+    // the filter follows the signal for CPU.
     class FMIF : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
         FMIF() {}
 
-        FMIF(stream<complex_t>* in, int bins) { init(in, bins); }
+        FMIF(stream<complex_t>* in, int bins, int hop = 1) { init(in, bins, hop); }
 
         ~FMIF() {
             if (!base_type::_block_init) { return; }
@@ -17,8 +21,10 @@ namespace dsp::noise_reduction {
             destroyBuffers();
         }
 
-        void init(stream<complex_t>* in, int bins) {
+        void init(stream<complex_t>* in, int bins, int hop = 1) {
+            assert(hop >= 1);
             _bins = bins;
+            _hop = hop;
             initBuffers();
             base_type::init(in);
         }
@@ -33,41 +39,71 @@ namespace dsp::noise_reduction {
             base_type::tempStart();
         }
 
+        void setHop(int hop) {
+            assert(base_type::_block_init);
+            assert(hop >= 1);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _hop = hop;
+            untilSearch = 0;
+            base_type::tempStart();
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             buffer::clear(buffer, _bins - 1);
-            buffer::clear(backFFTIn, _bins);
+            untilSearch = 0;
+            peak = 0;
             base_type::tempStart();
         }
 
         int process(int count, const complex_t* in, complex_t* out) {
             // Write new input data to buffer buffer
+            buffer = work.reserve(_bins - 1, count);
+            bufferStart = &buffer[_bins - 1];
             memcpy(bufferStart, in, count * sizeof(complex_t));
             
-            // Iterate the FFT
             for (int i = 0; i < count; i++) {
+                // Between searches, the peak is followed by only computing its bin and its two neighbours
+                if (untilSearch) {
+                    complex_t best;
+                    int bestBin = peak;
+                    float bestAmp = -1.0f;
+                    for (int d = -1; d <= 1; d++) {
+                        int k = (peak + d + _bins) % _bins;
+                        complex_t val;
+                        volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&val, (lv_32fc_t*)&buffer[i], (lv_32fc_t*)&binTaps[k * _bins], _bins);
+                        float amp = val.re * val.re + val.im * val.im;
+                        if (amp > bestAmp) {
+                            best = val;
+                            bestBin = k;
+                            bestAmp = amp;
+                        }
+                    }
+                    out[i] = best;
+                    peak = bestBin;
+                    untilSearch--;
+                    continue;
+                }
+
                 // Apply windows
                 volk_32fc_32f_multiply_32fc((lv_32fc_t*)forwFFTIn, (lv_32fc_t*)&buffer[i], fftWin, _bins);
 
                 // Do forward FFT
                 fftwf_execute(forwardPlan);
 
-                // Process bins here
+                // Find the bin of highest amplitude, the square root isn't needed to compare them
                 uint32_t idx;
-                volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)forwFFTOut, _bins);
+                volk_32fc_magnitude_squared_32f(ampBuf, (lv_32fc_t*)forwFFTOut, _bins);
                 volk_32f_index_max_32u(&idx, ampBuf, _bins);
+                peak = idx;
+                untilSearch = _hop - 1;
 
-                // Keep only the bin of highest amplitude
-                backFFTIn[idx] = forwFFTOut[idx];
-
-                // Do reverse FFT and get first element
-                fftwf_execute(backwardPlan);
-                out[i] = backFFTOut[_bins / 2];
-
-                // Reset the input buffer
-                backFFTIn[idx] = { 0, 0 };
+                // An inverse FFT of that bin alone, read at the middle of the window, is just the bin turned
+                // by the phase it accumulates up to there
+                out[i] = forwFFTOut[peak] * binTurns[peak];
             }
 
             // Move buffer buffer
@@ -88,21 +124,21 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         void initBuffers() {
             // Allocate FFT buffers
             forwFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
             forwFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
 
-            // Allocate and clear delay buffer
-            buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + 64000);
+            // Allocate and clear delay buffer, it grows later on if given larger blocks
+            buffer = work.reserve(0, _bins - 1 + buffer::WORK_BUFFER_INITIAL_SIZE);
             bufferStart = &buffer[_bins - 1];
             buffer::clear(buffer, _bins - 1);
 
-            // Clear backward FFT input since only one value is changed and reset at a time
-            buffer::clear(backFFTIn, _bins);
+            untilSearch = 0;
+            peak = 0;
 
             // Allocate amplitude buffer
             ampBuf = buffer::alloc<float>(_bins);
@@ -111,31 +147,39 @@ namespace dsp::noise_reduction {
             fftWin = buffer::alloc<float>(_bins);
             for (int i = 0; i < _bins; i++) { fftWin[i] = window::nuttall(i, _bins - 1); }
 
-            // Plan FFTs
+            // Phase of each bin at the middle of the window, and the window times the DFT of each bin turned by it
+            binTurns = buffer::alloc<complex_t>(_bins);
+            binTaps = buffer::alloc<complex_t>(_bins * _bins);
+            for (int k = 0; k < _bins; k++) {
+                double turn = 2.0 * DB_M_PI * (double)k * (double)(_bins / 2) / (double)_bins;
+                binTurns[k] = { (float)cos(turn), (float)sin(turn) };
+                for (int n = 0; n < _bins; n++) {
+                    double angle = turn - 2.0 * DB_M_PI * (double)((k * n) % _bins) / (double)_bins;
+                    binTaps[k * _bins + n] = { (float)(fftWin[n] * cos(angle)), (float)(fftWin[n] * sin(angle)) };
+                }
+            }
+
+            // Plan FFT
             forwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)forwFFTIn, (fftwf_complex*)forwFFTOut, FFTW_FORWARD, FFTW_ESTIMATE);
-            backwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)backFFTIn, (fftwf_complex*)backFFTOut, FFTW_BACKWARD, FFTW_ESTIMATE);
         }
 
         void destroyBuffers() {
             fftwf_destroy_plan(forwardPlan);
-            fftwf_destroy_plan(backwardPlan);
             fftwf_free(forwFFTIn);
             fftwf_free(forwFFTOut);
-            fftwf_free(backFFTIn);
-            fftwf_free(backFFTOut);
-            buffer::free(buffer);
+            work.free();
             buffer::free(ampBuf);
             buffer::free(fftWin);
+            buffer::free(binTurns);
+            buffer::free(binTaps);
         }
 
         complex_t* forwFFTIn;
         complex_t* forwFFTOut;
-        complex_t* backFFTIn;
-        complex_t* backFFTOut;
 
         fftwf_plan forwardPlan;
-        fftwf_plan backwardPlan;
 
+        buffer::WorkBuffer<complex_t> work;
         complex_t* buffer;
         complex_t* bufferStart;
 
@@ -143,7 +187,13 @@ namespace dsp::noise_reduction {
 
         float* ampBuf;
 
+        complex_t* binTurns;
+        complex_t* binTaps;
+
         int _bins;
+        int _hop;
+        int untilSearch = 0;
+        int peak = 0;
 
     }; 
 }
\ No newline at end of file
@@ -67,6 +67,8 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     protected:
         float _rate;
         float _invRate;
@@ -73,6 +73,8 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        int maxOutputSize(int count) { return count; }
+
     private:
         float* normBuffer;
         float _level  = -50.0f;
@@ -56,6 +56,8 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        virtual bool schedulable() { return true; }
+
         stream<O> out;
 
     protected:
@@ -0,0 +1,119 @@
+#include "overflow.h"
+#include <mutex>
+#include <algorithm>
+#include <fmt/format.h>
+#include <utils/flog.h>
+
+namespace dsp::overflow {
+    // Samples can arrive this early or late without being counted as dropped
+    static const double RATE_TOLERANCE = 0.005;
+    static const int64_t RATE_CHECK_INTERVAL_MS = 1000;
+
+    // The time base is restarted this often so that the tolerance doesn't grow forever
+    static const int64_t RATE_WINDOW_MS = 10000;
+
+    static std::mutex mtx;
+    static std::vector<Counters*> counters;
+
+    void Counters::dropped(uint64_t samples) {
+        int64_t now = wallTime();
+        drops++;
+        droppedSamples += samples;
+        lastDrop = now;
+        unlogged += samples;
+
+        // Rate limit the log
+        int64_t last = lastLog;
+        if (now - last < 1000 || !lastLog.compare_exchange_strong(last, now)) { return; }
+        flog::warn("{} dropped {} samples", name.empty() ? "Unnamed stream" : name, unlogged.exchange(0));
+    }
+
+    void Counters::reset() {
+        overruns = 0;
+        drops = 0;
+        droppedSamples = 0;
+        lastOverrun = 0;
+        lastDrop = 0;
+        unlogged = 0;
+    }
+
+    void RateCheck::start(double samplerate) {
+        _samplerate = samplerate;
+        startTime = 0;
+        received = 0;
+        lastCheck = 0;
+    }
+
+    void RateCheck::update(Counters& counters, int samples) {
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        // The time base starts with the first block
+        if (!startTime) {
+            startTime = now;
+            lastCheck = now;
+            return;
+        }
+        received += samples;
+        if (now - lastCheck < RATE_CHECK_INTERVAL_MS * 1000) { return; }
+        lastCheck = now;
+
+        // Anything missing beyond the tolerance and one block of jitter was lost
+        double expected = (double)(now - startTime) * 1e-6 * _samplerate;
+        double missing = expected - (double)received;
+        bool lost = (missing > expected * RATE_TOLERANCE + samples);
+        if (lost) { counters.dropped((uint64_t)missing); }
+
+        // Start again from here once something was lost, to not count it twice, or once the window is over
+        if (lost || now - startTime >= RATE_WINDOW_MS * 1000) {
+            startTime = now;
+            received = 0;
+        }
+    }
+
+    void add(const std::string& name, Counters* c) {
+        std::lock_guard<std::mutex> lck(mtx);
+        c->name = name;
+        if (std::find(counters.begin(), counters.end(), c) == counters.end()) { counters.push_back(c); }
+    }
+
+    void remove(Counters* c) {
+        std::lock_guard<std::mutex> lck(mtx);
+        counters.erase(std::remove(counters.begin(), counters.end(), c), counters.end());
+    }
+
+    std::vector<Info> snapshot() {
+        std::lock_guard<std::mutex> lck(mtx);
+        std::vector<Info> infos;
+        for (auto c : counters) {
+            Info info;
+            info.name = c->name;
+            info.overruns = c->overruns;
+            info.drops = c->drops;
+            info.droppedSamples = c->droppedSamples;
+            info.lastOverrun = c->lastOverrun;
+            info.lastDrop = c->lastDrop;
+            infos.push_back(info);
+        }
+        return infos;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lck(mtx);
+        for (auto c : counters) { c->reset(); }
+    }
+
+    static std::string ago(int64_t now, int64_t time) {
+        if (!time) { return "never"; }
+        return fmt::format("{:.1f}s ago", (double)(now - time) / 1000.0);
+    }
+
+    std::string report() {
+        int64_t now = wallTime();
+        std::string str;
+        for (const auto& info : snapshot()) {
+            str += fmt::format("{}: {} overruns (last {}), {} samples dropped in {} drops (last {})\n",
+                               info.name, info.overruns, ago(now, info.lastOverrun), info.droppedSamples, info.drops, ago(now, info.lastDrop));
+        }
+        return str;
+    }
+}
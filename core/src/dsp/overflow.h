@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace dsp {
+    // Accounting of the places where the signal path can't keep up. An overrun is a producer
+    // that had to wait for its consumer, a drop is data that was thrown away for good.
+    // Counters are owned by streams and blocks, only the named ones show up in the reports.
+    namespace overflow {
+        inline int64_t wallTime() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        class Counters {
+        public:
+            inline void overrun() {
+                overruns++;
+                lastOverrun = wallTime();
+            }
+
+            // Also logs the drops, at most once per second per counter
+            void dropped(uint64_t samples);
+
+            void reset();
+
+            std::atomic<uint64_t> overruns = 0;
+            std::atomic<uint64_t> drops = 0;
+            std::atomic<uint64_t> droppedSamples = 0;
+            std::atomic<int64_t> lastOverrun = 0;   // Unix time in milliseconds, zero if never
+            std::atomic<int64_t> lastDrop = 0;      // Unix time in milliseconds, zero if never
+
+            std::string name;
+
+        private:
+            std::atomic<int64_t> lastLog = 0;
+            std::atomic<uint64_t> unlogged = 0;
+        };
+
+        // Detects samples lost before reaching us (e.g. by a driver) by comparing what a
+        // source receives to what it should have received at its samplerate
+        class RateCheck {
+        public:
+            void start(double samplerate);
+            void update(Counters& counters, int samples);
+
+        private:
+            double _samplerate = 0.0;
+            int64_t startTime = 0;
+            uint64_t received = 0;
+            int64_t lastCheck = 0;
+        };
+
+        struct Info {
+            std::string name;
+            uint64_t overruns;
+            uint64_t drops;
+            uint64_t droppedSamples;
+            int64_t lastOverrun;
+            int64_t lastDrop;
+        };
+
+        void add(const std::string& name, Counters* counters);
+        void remove(Counters* counters);
+
+        std::vector<Info> snapshot();
+        void reset();
+
+        // Human readable list of the named counters
+        std::string report();
+    }
+}
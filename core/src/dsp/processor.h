@@ -66,9 +66,41 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        virtual bool schedulable() { return true; }
+
+        // Largest number of samples written to the output for the given number of input samples.
+        // Blocks that know it get their output stream sized to their input instead of the default size,
+        // the others return -1.
+        virtual int maxOutputSize(int count) { return -1; }
+
+        // Describe the output of the coming pass from the description of its input, called before the pass
+        // with the block's state as it is before processing. The default is for blocks that don't change the rate.
+        virtual void mapMetadata(const Metadata& in, Metadata& out) {
+            out.update(in);
+        }
+
         stream<O> out;
 
     protected:
+        void prepareOutputs() {
+            // Blocks that don't know their output size don't know how to carry the metadata either
+            if (maxOutputSize(0) < 0) {
+                out.writeMeta.clear();
+                return;
+            }
+
+            // Peek at the input, run() reads the same data again
+            int count = _in->read();
+            if (count < 0) { return; }
+            if (buffer::adaptiveStreams()) { out.fit(maxOutputSize(count)); }
+            if (_in->readMeta.valid) {
+                mapMetadata(_in->readMeta, out.writeMeta);
+            }
+            else {
+                out.writeMeta.clear();
+            }
+        }
+
         stream<I>* _in;
     };
 }
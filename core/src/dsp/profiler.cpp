@@ -0,0 +1,198 @@
+#include "profiler.h"
+#include "buffer/buffer.h"
+#include "overflow.h"
+#include "latency.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <fmt/format.h>
+#include <utils/flog.h>
+#include <utils/threading.h>
+#ifndef _MSC_VER
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+
+namespace dsp::profiler {
+    struct Entry {
+        std::string name;
+        Stats* stats;
+
+        // Window used for the rates
+        uint64_t lastTime = 0;
+        uint64_t lastIn = 0;
+        uint64_t lastOut = 0;
+        uint64_t lastProcessNs = 0;
+        double inRate = 0.0;
+        double outRate = 0.0;
+        double load = 0.0;
+    };
+
+    // Rates are only refreshed once this much time went by, whoever is asking for them
+    static const uint64_t RATE_INTERVAL_NS = 500000000;
+
+    static std::atomic<bool> enabled = false;
+    static std::mutex mtx;
+    static std::map<const void*, Entry> entries;
+    static thread_local Stats* currentStats = NULL;
+
+    static threading::thread logThread;
+    static std::mutex logMtx;
+    static std::condition_variable logCV;
+    static bool logRunning = false;
+
+    static std::string typeName(const std::type_info& type) {
+#ifndef _MSC_VER
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+        if (demangled) {
+            std::string name = demangled;
+            ::free(demangled);
+            return name;
+        }
+#endif
+        return type.name();
+    }
+
+    static uint64_t processNs(const Stats* stats) {
+        uint64_t busy = stats->busyNs;
+        uint64_t waits = stats->readWaitNs + stats->swapWaitNs;
+        return (busy > waits) ? (busy - waits) : 0;
+    }
+
+    void setEnabled(bool enable) {
+        enabled = enable;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    void add(const void* id, const std::type_info& type, Stats* stats) {
+        std::lock_guard<std::mutex> lck(mtx);
+        Entry e;
+        e.name = typeName(type);
+        e.stats = stats;
+        entries[id] = e;
+    }
+
+    void remove(const void* id) {
+        std::lock_guard<std::mutex> lck(mtx);
+        entries.erase(id);
+    }
+
+    std::vector<BlockInfo> snapshot() {
+        std::lock_guard<std::mutex> lck(mtx);
+        std::vector<BlockInfo> infos;
+        uint64_t t = now();
+        for (auto& [id, e] : entries) {
+            Stats* s = e.stats;
+            uint64_t in = s->samplesIn;
+            uint64_t out = s->samplesOut;
+            uint64_t proc = processNs(s);
+
+            // Refresh the rates, smoothed over the last few intervals
+            uint64_t dt = t - e.lastTime;
+            if (dt >= RATE_INTERVAL_NS) {
+                double secs = (double)dt * 1e-9;
+                bool first = !e.lastTime;
+                double inRate = (double)(in - e.lastIn) / secs;
+                double outRate = (double)(out - e.lastOut) / secs;
+                double load = (double)(proc - e.lastProcessNs) * 1e-9 / secs;
+                e.inRate = first ? 0.0 : (0.5 * e.inRate + 0.5 * inRate);
+                e.outRate = first ? 0.0 : (0.5 * e.outRate + 0.5 * outRate);
+                e.load = first ? 0.0 : (0.5 * e.load + 0.5 * load);
+                e.lastTime = t;
+                e.lastIn = in;
+                e.lastOut = out;
+                e.lastProcessNs = proc;
+            }
+
+            BlockInfo info;
+            info.name = e.name;
+            info.id = id;
+            info.runs = s->runs;
+            info.readWait = (double)s->readWaitNs * 1e-9;
+            info.process = (double)proc * 1e-9;
+            info.swapWait = (double)s->swapWaitNs * 1e-9;
+            info.samplesIn = in;
+            info.samplesOut = out;
+            info.inRate = e.inRate;
+            info.outRate = e.outRate;
+            info.load = e.load;
+            infos.push_back(info);
+        }
+        return infos;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lck(mtx);
+        for (auto& [id, e] : entries) {
+            Stats* s = e.stats;
+            s->runs = 0;
+            s->busyNs = 0;
+            s->readWaitNs = 0;
+            s->swapWaitNs = 0;
+            s->samplesIn = 0;
+            s->samplesOut = 0;
+            e.lastTime = 0;
+            e.lastIn = 0;
+            e.lastOut = 0;
+            e.lastProcessNs = 0;
+            e.inRate = 0.0;
+            e.outRate = 0.0;
+            e.load = 0.0;
+        }
+    }
+
+    std::string dump() {
+        auto infos = snapshot();
+        std::sort(infos.begin(), infos.end(), [](const BlockInfo& a, const BlockInfo& b) { return a.load > b.load; });
+
+        std::string str = fmt::format("{:>6} {:>10} {:>10} {:>10} {:>12} {:>12}  {}\n", "Load", "Process", "Read wait", "Swap wait", "In (S/s)", "Out (S/s)", "Block");
+        for (const auto& info : infos) {
+            str += fmt::format("{:>5.1f}% {:>9.3f}s {:>9.3f}s {:>9.3f}s {:>12.0f} {:>12.0f}  {} ({})\n",
+                               info.load * 100.0, info.process, info.readWait, info.swapWait, info.inRate, info.outRate, info.name, info.id);
+        }
+        return str;
+    }
+
+    static void logWorker(int intervalSec) {
+        std::unique_lock<std::mutex> lck(logMtx);
+        while (logRunning) {
+            logCV.wait_for(lck, std::chrono::seconds(intervalSec), [] { return !logRunning; });
+            if (!logRunning) { break; }
+            flog::info("DSP block statistics:\n{}{}{}", dump(), buffer::memoryReport(), overflow::report());
+            std::string latencies = latency::report();
+            if (!latencies.empty()) { flog::info("Signal path latency:\n{}", latencies); }
+            std::string policies = threading::getPolicyReport();
+            if (!policies.empty()) { flog::info("Thread policies:\n{}", policies); }
+        }
+    }
+
+    void startLogging(int intervalSec) {
+        if (logThread.joinable() || intervalSec <= 0) { return; }
+        enabled = true;
+        logRunning = true;
+        logThread = threading::thread("dspProf:log", logWorker, intervalSec);
+    }
+
+    void stopLogging() {
+        if (!logThread.joinable()) { return; }
+        {
+            std::lock_guard<std::mutex> lck(logMtx);
+            logRunning = false;
+        }
+        logCV.notify_all();
+        logThread.join();
+    }
+
+    Stats* current() {
+        return enabled ? currentStats : NULL;
+    }
+
+    void setCurrent(Stats* stats) {
+        currentStats = stats;
+    }
+}
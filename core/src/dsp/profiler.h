@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace dsp {
+    // Per-block runtime counters. The busy time covers whole passes of a block, the time spent blocked
+    // in stream calls is accounted by the streams themselves to the block run by the calling thread.
+    // The processing time is what remains once the waits are removed from the busy time.
+    namespace profiler {
+        struct Stats {
+            std::atomic<uint64_t> runs = 0;
+            std::atomic<uint64_t> busyNs = 0;
+            std::atomic<uint64_t> readWaitNs = 0;
+            std::atomic<uint64_t> swapWaitNs = 0;
+            std::atomic<uint64_t> samplesIn = 0;
+            std::atomic<uint64_t> samplesOut = 0;
+        };
+
+        struct BlockInfo {
+            std::string name;
+            const void* id;
+            uint64_t runs;
+            double readWait;    // Seconds
+            double process;     // Seconds
+            double swapWait;    // Seconds
+            uint64_t samplesIn;
+            uint64_t samplesOut;
+            double inRate;      // Samples per second over the last few seconds
+            double outRate;     // Samples per second over the last few seconds
+            double load;        // Fraction of the wall time spent processing over the last few seconds
+        };
+
+        void setEnabled(bool enabled);
+        bool isEnabled();
+
+        void add(const void* id, const std::type_info& type, Stats* stats);
+        void remove(const void* id);
+
+        std::vector<BlockInfo> snapshot();
+        void reset();
+
+        // Human readable table of all blocks, busiest first
+        std::string dump();
+
+        // Periodically log the table, used when running headless
+        void startLogging(int intervalSec);
+        void stopLogging();
+
+        // Stats of the block run by the calling thread, NULL if there is none or profiling is disabled
+        Stats* current();
+        void setCurrent(Stats* stats);
+
+        inline uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        enum Stage {
+            STAGE_READ,
+            STAGE_SWAP
+        };
+
+        // Accounts a blocking stream call to the block run by the calling thread
+        class Wait {
+        public:
+            inline Wait(Stage stage) : stats(current()), stage(stage) {
+                if (stats) { start = now(); }
+            }
+
+            inline ~Wait() {
+                if (!stats) { return; }
+                uint64_t ns = now() - start;
+                if (stage == STAGE_READ) {
+                    stats->readWaitNs += ns;
+                    if (count > 0) { stats->samplesIn += count; }
+                }
+                else {
+                    stats->swapWaitNs += ns;
+                    if (count > 0) { stats->samplesOut += count; }
+                }
+            }
+
+            inline int samples(int n) {
+                count = n;
+                return n;
+            }
+
+        private:
+            Stats* stats;
+            Stage stage;
+            uint64_t start = 0;
+            int count = 0;
+        };
+    }
+}
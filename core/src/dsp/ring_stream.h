@@ -0,0 +1,278 @@
+#pragma once
+#include <assert.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "stream.h"
+
+namespace dsp {
+    // Stream that can queue several blocks between the writer and the reader.
+    // Slots are handed over through a single-producer/single-consumer index pair,
+    // the writer only blocks when all slots are full and the reader only when all are empty.
+    // The writeBuf/readBuf/swap/read/flush semantics are the same as those of dsp::stream.
+    // Slot buffers are only allocated once the writer first hands a block of its own over to them,
+    // a ring only ever fed with shared blocks therefore never allocates more than its writeBuf.
+    template <class T>
+    class ring_stream : public stream<T> {
+        using base_type = stream<T>;
+    public:
+        ring_stream(int slots = 4, int samples = STREAM_BUFFER_SIZE) : base_type(0) {
+            assert(slots >= 1);
+            slotCount = slots;
+            bufferSize = samples;
+            allocate();
+        }
+
+        ~ring_stream() {
+            free();
+        }
+
+        void setBufferSize(int samples) {
+            free();
+            bufferSize = samples;
+            allocate();
+        }
+
+        inline bool swap(int size) {
+            profiler::Wait wait(profiler::STAGE_SWAP);
+            uint64_t h = head.load(std::memory_order_relaxed);
+
+            // Wait for a free slot or to be stopped, having to wait means the reader isn't keeping up
+            if ((h - tail.load(std::memory_order_acquire)) >= slotCount && !writerStop) {
+                base_type::overflow.overrun();
+                std::unique_lock<std::mutex> lck(waitMtx);
+                writerWaiting = true;
+                spaceCV.wait(lck, [this, h] { return (h - tail.load()) < slotCount || writerStop; });
+                writerWaiting = false;
+            }
+
+            // If writer was stopped, abandon operation
+            if (writerStop) { return false; }
+            wait.samples(size);
+
+            // Hand the written buffer over to the slot and take back its previous buffer
+            int id = h % slotCount;
+            T* temp = slots[id];
+            slots[id] = base_type::writeBuf;
+            base_type::writeBuf = temp;
+            std::swap(caps[id], base_type::writeCap);
+            if (!base_type::writeBuf) {
+                base_type::writeBuf = base_type::allocBuffer(caps[id]);
+                base_type::writeCap = caps[id];
+            }
+            sizes[id] = size;
+            if (base_type::latencyProbe) { base_type::latencyProbe->record(base_type::writeMeta); }
+            metas[id] = base_type::writeMeta;
+            base_type::writeMeta.clear();
+            head.store(h + 1);
+
+            // Notify the reader only if it's actually waiting
+            if (readerWaiting) {
+                std::lock_guard<std::mutex> lck(waitMtx);
+                dataCV.notify_all();
+            }
+            scheduler::notify();
+
+            return true;
+        }
+
+        inline bool swapShared(T* data, int size, const std::shared_ptr<void>& owner) {
+            profiler::Wait wait(profiler::STAGE_SWAP);
+            uint64_t h = head.load(std::memory_order_relaxed);
+
+            // Wait for a free slot or to be stopped, having to wait means the reader isn't keeping up
+            if ((h - tail.load(std::memory_order_acquire)) >= slotCount && !writerStop) {
+                base_type::overflow.overrun();
+                std::unique_lock<std::mutex> lck(waitMtx);
+                writerWaiting = true;
+                spaceCV.wait(lck, [this, h] { return (h - tail.load()) < slotCount || writerStop; });
+                writerWaiting = false;
+            }
+
+            // If writer was stopped, abandon operation
+            if (writerStop) { return false; }
+            wait.samples(size);
+
+            // Park the slot's own buffer until the reader releases the shared one
+            int id = h % slotCount;
+            parked[id] = slots[id];
+            slots[id] = data;
+            owners[id] = owner;
+            sizes[id] = size;
+            if (base_type::latencyProbe) { base_type::latencyProbe->record(base_type::writeMeta); }
+            metas[id] = base_type::writeMeta;
+            base_type::writeMeta.clear();
+            head.store(h + 1);
+
+            // Notify the reader only if it's actually waiting
+            if (readerWaiting) {
+                std::lock_guard<std::mutex> lck(waitMtx);
+                dataCV.notify_all();
+            }
+            scheduler::notify();
+
+            return true;
+        }
+
+        inline int read() {
+            profiler::Wait wait(profiler::STAGE_READ);
+            uint64_t t = tail.load(std::memory_order_relaxed);
+
+            // Wait for data to be ready or to be stopped
+            if (head.load() == t && !readerStop) {
+                std::unique_lock<std::mutex> lck(waitMtx);
+                readerWaiting = true;
+                dataCV.wait(lck, [this, t] { return head.load() != t || readerStop; });
+                readerWaiting = false;
+            }
+
+            if (readerStop) { return -1; }
+
+            int id = t % slotCount;
+            base_type::readBuf = slots[id];
+            base_type::readMeta = metas[id];
+
+            // Reading the same slot more than once until it's flushed is allowed, only count it once
+            if (base_type::readSeen) { return sizes[id]; }
+            base_type::readSeen = true;
+            return wait.samples(sizes[id]);
+        }
+
+        int getReadCapacity() {
+            int id = tail.load(std::memory_order_relaxed) % slotCount;
+            return owners[id] ? 0 : caps[id];
+        }
+
+        bool exchangeReadBuf(T*& buf, int& cap) {
+            int id = tail.load(std::memory_order_relaxed) % slotCount;
+            if (owners[id] || cap < caps[id]) { return false; }
+            std::swap(slots[id], buf);
+            std::swap(caps[id], cap);
+            base_type::readBuf = slots[id];
+            return true;
+        }
+
+        inline void flush() {
+            // Release the slot being read, if any
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            if (head.load(std::memory_order_acquire) == t) { return; }
+            releaseShared(t % slotCount);
+            base_type::readSeen = false;
+            tail.store(t + 1);
+
+            // Notify the writer only if it's actually waiting
+            if (writerWaiting) {
+                std::lock_guard<std::mutex> lck(waitMtx);
+                spaceCV.notify_all();
+            }
+            scheduler::notify();
+        }
+
+        void stopWriter() {
+            {
+                std::lock_guard<std::mutex> lck(waitMtx);
+                writerStop = true;
+            }
+            spaceCV.notify_all();
+        }
+
+        void clearWriteStop() {
+            writerStop = false;
+        }
+
+        void stopReader() {
+            {
+                std::lock_guard<std::mutex> lck(waitMtx);
+                readerStop = true;
+            }
+            dataCV.notify_all();
+        }
+
+        void clearReadStop() {
+            readerStop = false;
+        }
+
+        bool readable() {
+            return head.load() != tail.load() || readerStop;
+        }
+
+        bool writable() {
+            return (head.load() - tail.load()) < slotCount || writerStop;
+        }
+
+        void free() {
+            for (int i = 0; i < slots.size(); i++) {
+                releaseShared(i);
+            }
+            for (int i = 0; i < slots.size(); i++) {
+                if (slots[i]) { base_type::freeBuffer(slots[i], caps[i]); }
+            }
+            slots.clear();
+            caps.clear();
+            sizes.clear();
+            metas.clear();
+            parked.clear();
+            owners.clear();
+            if (base_type::writeBuf) { base_type::freeBuffer(base_type::writeBuf, base_type::writeCap); }
+            base_type::writeBuf = NULL;
+            base_type::readBuf = NULL;
+            base_type::writeCap = 0;
+        }
+
+        int getSlotCount() {
+            return slotCount;
+        }
+
+        // Number of blocks written but not yet flushed by the reader
+        int getQueuedCount() {
+            return head.load() - tail.load();
+        }
+
+    private:
+        void allocate() {
+            // Only the writer's buffer, slots get theirs the first time they're swapped with it
+            slots.resize(slotCount, NULL);
+            caps.resize(slotCount, 0);
+            sizes.resize(slotCount, 0);
+            metas.resize(slotCount);
+            parked.resize(slotCount, NULL);
+            owners.resize(slotCount);
+            base_type::writeBuf = base_type::allocBuffer(bufferSize);
+            base_type::writeCap = bufferSize;
+            base_type::readBuf = slots[0];
+            head = 0;
+            tail = 0;
+            base_type::readSeen = false;
+        }
+
+        inline void releaseShared(int id) {
+            if (!owners[id]) { return; }
+            slots[id] = parked[id];
+            parked[id] = NULL;
+            owners[id].reset();
+        }
+
+        unsigned int slotCount;
+        int bufferSize;
+        std::vector<T*> slots;
+        std::vector<int> caps;
+        std::vector<int> sizes;
+        std::vector<Metadata> metas;
+
+        // Buffers set aside while a slot holds a shared one
+        std::vector<T*> parked;
+        std::vector<std::shared_ptr<void>> owners;
+
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+
+        std::mutex waitMtx;
+        std::condition_variable spaceCV;
+        std::condition_variable dataCV;
+        std::atomic<bool> writerWaiting = false;
+        std::atomic<bool> readerWaiting = false;
+
+        std::atomic<bool> readerStop = false;
+        std::atomic<bool> writerStop = false;
+    };
+}
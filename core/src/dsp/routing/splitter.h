@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include "../sink.h"
 
 namespace dsp::routing {
@@ -10,10 +11,38 @@ namespace dsp::routing {
 
         Splitter(stream<T>* in) { base_type::init(in); }
 
+        // The input block is always flushed before run() can block on an output, so there is never anything
+        // left pending on the old input. A shared block only partially handed out is ours and is finished after the switch.
+        void setInput(stream<T>* in) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            base_type::setInput(in);
+            base_type::tempStart();
+        }
+
+        // In shared mode, every bound stream gets a read-only view of the input block instead of a copy.
+        // The block is taken out of the input so that it can be flushed right away, and goes back to a pool
+        // once the last consumer has flushed its view. Consumers must therefore never write to their input buffer.
+        void setShared(bool enabled) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (enabled == shared) { return; }
+            base_type::tempStop();
+            shared = enabled;
+            pendingOwner.reset();
+            served.clear();
+            base_type::tempStart();
+        }
+
+        bool isShared() {
+            return shared;
+        }
+
         void bindStream(stream<T>* stream) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            
+
             // Check that the stream isn't already bound
             if (std::find(streams.begin(), streams.end(), stream) != streams.end()) {
                 throw std::runtime_error("[Splitter] Tried to bind stream to that is already bound");
@@ -29,7 +58,7 @@ namespace dsp::routing {
         void unbindStream(stream<T>* stream) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            
+
             // Check that the stream is bound
             auto sit = std::find(streams.begin(), streams.end(), stream);
             if (sit == streams.end()) {
@@ -39,16 +68,24 @@ namespace dsp::routing {
             // Add to the list
             base_type::tempStop();
             streams.erase(sit);
+            served.erase(std::remove(served.begin(), served.end(), stream), served.end());
             base_type::unregisterOutput(stream);
             base_type::tempStart();
         }
 
         int run() {
+            // Finish handing out a shared block interrupted by a stop before taking a new one
+            if (pendingOwner) { return serve(); }
+
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            if (shared) { return runShared(count); }
+
             for (const auto& stream : streams) {
+                stream->reserve(count);
                 memcpy(stream->writeBuf, base_type::_in->readBuf, count * sizeof(T));
+                stream->writeMeta = base_type::_in->readMeta;
                 if (!stream->swap(count)) {
                     base_type::_in->flush();
                     return -1;
@@ -61,7 +98,91 @@ namespace dsp::routing {
         }
 
     protected:
+        // Buffers taken out of the input, recycled once all consumers are done with them.
+        // Owned jointly by the splitter and the blocks in flight so that it outlives both.
+        struct Pool {
+            ~Pool() {
+                for (const auto& b : buffers) {
+                    buffer::track(buffer::USAGE_STREAM, -(int64_t)b.second * sizeof(T), -1);
+                    buffer::free(b.first);
+                }
+            }
+
+            // Get a buffer of at least the given capacity, the capacity is updated to the actual one
+            T* take(int& cap) {
+                {
+                    std::lock_guard<std::mutex> lck(mtx);
+                    for (int i = 0; i < buffers.size(); i++) {
+                        if (buffers[i].second < cap) { continue; }
+                        T* buf = buffers[i].first;
+                        cap = buffers[i].second;
+                        buffers[i] = buffers.back();
+                        buffers.pop_back();
+                        return buf;
+                    }
+                }
+                buffer::track(buffer::USAGE_STREAM, (int64_t)cap * sizeof(T), 1);
+                return buffer::alloc<T>(cap);
+            }
+
+            void give(T* buf, int cap) {
+                std::lock_guard<std::mutex> lck(mtx);
+                buffers.push_back(std::make_pair(buf, cap));
+            }
+
+            std::mutex mtx;
+            std::vector<std::pair<T*, int>> buffers;
+        };
+
+        int runShared(int count) {
+            // Nobody to share it with
+            if (streams.empty()) {
+                base_type::_in->flush();
+                return count;
+            }
+
+            // Take the block out of the input, giving it a pooled buffer of the same size in exchange.
+            // If the input can't give its buffer away, the block is copied instead.
+            int cap = std::max<int>(base_type::_in->getReadCapacity(), count);
+            T* buf = pool->take(cap);
+            if (!base_type::_in->exchangeReadBuf(buf, cap)) {
+                memcpy(buf, base_type::_in->readBuf, count * sizeof(T));
+            }
+            pendingMeta = base_type::_in->readMeta;
+            pendingCount = count;
+            base_type::_in->flush();
+
+            // The last consumer to release the block gives the buffer back to the pool
+            std::shared_ptr<Pool> p = pool;
+            pendingOwner = std::shared_ptr<void>(buf, [p, cap](void* b) { p->give((T*)b, cap); });
+            served.clear();
+
+            return serve();
+        }
+
+        int serve() {
+            // Hand the block to every stream that doesn't have it yet
+            T* data = (T*)pendingOwner.get();
+            for (const auto& stream : streams) {
+                if (std::find(served.begin(), served.end(), stream) != served.end()) { continue; }
+                stream->writeMeta = pendingMeta;
+                if (!stream->swapShared(data, pendingCount, pendingOwner)) { return -1; }
+                served.push_back(stream);
+            }
+            pendingOwner.reset();
+            served.clear();
+            return pendingCount;
+        }
+
         std::vector<stream<T>*> streams;
 
+        // Shared mode
+        bool shared = false;
+        std::shared_ptr<Pool> pool = std::make_shared<Pool>();
+        std::shared_ptr<void> pendingOwner;
+        Metadata pendingMeta;
+        int pendingCount = 0;
+        std::vector<stream<T>*> served;
+
     };
-}
\ No newline at end of file
+}
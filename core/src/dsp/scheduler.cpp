@@ -0,0 +1,149 @@
+#include "scheduler.h"
+#include "block.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <utils/flog.h>
+
+namespace dsp::scheduler {
+    struct Entry {
+        block* blk;
+        std::atomic<bool> busy = false;
+    };
+
+    struct Worker {
+        std::mutex mtx;
+        std::vector<std::shared_ptr<Entry>> entries;
+        int cursor = 0;
+        threading::thread thread;
+    };
+
+    static std::vector<std::unique_ptr<Worker>> workers;
+    static std::atomic<bool> running = false;
+    static std::atomic<int> nextWorker = 0;
+
+    static std::atomic<uint64_t> epoch = 0;
+    static std::atomic<int> idleCount = 0;
+    static std::mutex idleMtx;
+    static std::condition_variable idleCV;
+
+    static std::shared_ptr<Entry> claim(Worker* w) {
+        std::lock_guard<std::mutex> lck(w->mtx);
+        int n = w->entries.size();
+        for (int i = 0; i < n; i++) {
+            int id = (w->cursor + i) % n;
+            auto& e = w->entries[id];
+            if (e->busy || !e->blk->isReady()) { continue; }
+
+            // Make sure no other worker took it in the meantime
+            bool expected = false;
+            if (!e->busy.compare_exchange_strong(expected, true)) { continue; }
+
+            // Start the next scan after this block so that all blocks get serviced
+            w->cursor = (id + 1) % n;
+            return e;
+        }
+        return NULL;
+    }
+
+    static void workerLoop(int id) {
+        int count = workers.size();
+        while (running) {
+            uint64_t seen = epoch.load();
+
+            // Look for work in our own blocks first, then try to steal from the other workers
+            std::shared_ptr<Entry> e = claim(workers[id].get());
+            for (int i = 1; i < count && !e; i++) {
+                e = claim(workers[(id + i) % count].get());
+            }
+
+            if (e) {
+                e->blk->runOnce();
+                e->busy = false;
+                continue;
+            }
+
+            // Nothing to do, wait for a stream to change state
+            idleCount++;
+            {
+                std::unique_lock<std::mutex> lck(idleMtx);
+                idleCV.wait_for(lck, std::chrono::milliseconds(10), [seen] { return epoch.load() != seen || !running; });
+            }
+            idleCount--;
+        }
+    }
+
+    void init(int workerCount) {
+        if (running) { return; }
+        if (workerCount <= 0) { workerCount = std::max<int>(std::thread::hardware_concurrency(), 1); }
+
+        running = true;
+        for (int i = 0; i < workerCount; i++) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (int i = 0; i < workerCount; i++) {
+            workers[i]->thread = threading::thread("dspSched:worker", workerLoop, i);
+        }
+        flog::info("DSP scheduler started with {} workers", workerCount);
+    }
+
+    void stop() {
+        if (!running) { return; }
+        {
+            std::lock_guard<std::mutex> lck(idleMtx);
+            running = false;
+        }
+        idleCV.notify_all();
+        for (auto& w : workers) {
+            if (w->thread.joinable()) { w->thread.join(); }
+        }
+        workers.clear();
+    }
+
+    bool isEnabled() {
+        return running;
+    }
+
+    int getWorkerCount() {
+        return workers.size();
+    }
+
+    void add(block* blk) {
+        auto e = std::make_shared<Entry>();
+        e->blk = blk;
+
+        // Spread blocks over the workers, stealing will balance the rest
+        Worker* w = workers[nextWorker++ % workers.size()].get();
+        {
+            std::lock_guard<std::mutex> lck(w->mtx);
+            w->entries.push_back(e);
+        }
+        notify();
+    }
+
+    void remove(block* blk) {
+        std::shared_ptr<Entry> e;
+        for (auto& w : workers) {
+            std::lock_guard<std::mutex> lck(w->mtx);
+            auto it = std::find_if(w->entries.begin(), w->entries.end(), [blk](const std::shared_ptr<Entry>& e) { return e->blk == blk; });
+            if (it == w->entries.end()) { continue; }
+            e = *it;
+            w->entries.erase(it);
+            w->cursor = 0;
+            break;
+        }
+        if (!e) { return; }
+
+        // The caller already stopped the block's streams so a running pass will return shortly
+        while (e->busy) { threading::sleep(1); }
+    }
+
+    void notify() {
+        if (!running) { return; }
+        epoch++;
+        if (!idleCount) { return; }
+        std::lock_guard<std::mutex> lck(idleMtx);
+        idleCV.notify_one();
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+namespace dsp {
+    class block;
+
+    // Optional replacement for the thread-per-block model. When enabled, schedulable blocks
+    // don't get their own thread, a fixed pool of workers runs them whenever all of their
+    // inputs have data and all of their outputs have room. Each worker services its own
+    // blocks first and steals ready blocks from the other workers when it runs out of work.
+    namespace scheduler {
+        // Start the worker pool, a worker count of zero or less means one per CPU core
+        void init(int workerCount);
+        void stop();
+        bool isEnabled();
+        int getWorkerCount();
+
+        void add(block* blk);
+        void remove(block* blk);
+
+        // Called by streams when data or room becomes available
+        void notify();
+    }
+}
@@ -29,6 +29,8 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        virtual bool schedulable() { return true; }
+
     protected:
         stream<T>* _in;
     };
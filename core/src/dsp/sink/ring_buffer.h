@@ -28,6 +28,9 @@ namespace dsp::sink {
             return count;
         }
 
+        // Writing to the ring buffer can block
+        bool schedulable() { return false; }
+
         buffer::RingBuffer<T> data;
 
     private:
@@ -2,12 +2,23 @@
 #include <string.h>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <algorithm>
 #include <volk/volk.h>
 #include "buffer/buffer.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "overflow.h"
+#include "metadata.h"
+#include "latency.h"
 
 // 1MSample buffer
 #define STREAM_BUFFER_SIZE 1000000
 
+// Smallest size a stream is shrunk to when fitted to the blocks going through it
+#define STREAM_MIN_BUFFER_SIZE 4096
+
 namespace dsp {
     class untyped_stream {
     public:
@@ -19,41 +30,113 @@ namespace dsp {
         virtual void clearWriteStop() {}
         virtual void stopReader() {}
         virtual void clearReadStop() {}
+        virtual bool readable() { return true; }
+        virtual bool writable() { return true; }
     };
 
     template <class T>
     class stream : public untyped_stream {
     public:
         stream() {
-            writeBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
-            readBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+            writeBuf = allocBuffer(STREAM_BUFFER_SIZE);
+            readBuf = allocBuffer(STREAM_BUFFER_SIZE);
+            writeCap = STREAM_BUFFER_SIZE;
+            readCap = STREAM_BUFFER_SIZE;
         }
 
         virtual ~stream() {
+            if (!overflow.name.empty()) { overflow::remove(&overflow); }
             free();
         }
 
         virtual void setBufferSize(int samples) {
-            buffer::free(writeBuf);
-            buffer::free(readBuf);
-            writeBuf = buffer::alloc<T>(samples);
-            readBuf = buffer::alloc<T>(samples);
+            releaseShared();
+            freeBuffer(writeBuf, writeCap);
+            freeBuffer(readBuf, readCap);
+            writeBuf = allocBuffer(samples);
+            readBuf = allocBuffer(samples);
+            writeCap = samples;
+            readCap = samples;
+        }
+
+        // Number of samples that can be written to writeBuf, only meaningful to the writer
+        int getBufferSize() {
+            return writeCap;
+        }
+
+        // Grow writeBuf so that it can hold at least the given number of samples.
+        // Must be called by the writer before it starts writing, the content of writeBuf is not kept.
+        inline void reserve(int samples) {
+            if (samples <= writeCap) { return; }
+            resizeWriteBuf(samples + (samples >> 2));
+        }
+
+        // Same as reserve() but also shrinks writeBuf if it's much larger than needed.
+        // The read buffer gets resized once it comes back to the writer.
+        inline void fit(int samples) {
+            samples = std::max<int>(samples, STREAM_MIN_BUFFER_SIZE);
+            if (samples <= writeCap && writeCap < 4 * samples) { return; }
+            resizeWriteBuf(samples + (samples >> 2));
         }
 
         virtual inline bool swap(int size) {
+            profiler::Wait wait(profiler::STAGE_SWAP);
             {
-                // Wait to either swap or stop
+                // Wait to either swap or stop, having to wait means the reader isn't keeping up
                 std::unique_lock<std::mutex> lck(swapMtx);
+                if (!canSwap && !writerStop) { overflow.overrun(); }
                 swapCV.wait(lck, [this] { return (canSwap || writerStop); });
 
                 // If writer was stopped, abandon operation
                 if (writerStop) { return false; }
+                wait.samples(size);
 
                 // Swap buffers
                 dataSize = size;
                 T* temp = writeBuf;
                 writeBuf = readBuf;
                 readBuf = temp;
+                std::swap(writeCap, readCap);
+                if (latencyProbe) { latencyProbe->record(writeMeta); }
+                readMeta = writeMeta;
+                writeMeta.clear();
+                canSwap = false;
+            }
+
+            // Notify reader that some data is ready
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                dataReady = true;
+            }
+            rdyCV.notify_all();
+            scheduler::notify();
+
+            return true;
+        }
+
+        // Hand a buffer owned by someone else over to the reader instead of copying it into writeBuf.
+        // The reader sees it as readBuf and the owner reference is dropped when the reader flushes,
+        // the writer must not touch the data until then.
+        virtual inline bool swapShared(T* data, int size, const std::shared_ptr<void>& owner) {
+            profiler::Wait wait(profiler::STAGE_SWAP);
+            {
+                // Wait to either swap or stop, having to wait means the reader isn't keeping up
+                std::unique_lock<std::mutex> lck(swapMtx);
+                if (!canSwap && !writerStop) { overflow.overrun(); }
+                swapCV.wait(lck, [this] { return (canSwap || writerStop); });
+
+                // If writer was stopped, abandon operation
+                if (writerStop) { return false; }
+                wait.samples(size);
+
+                // Keep our own read buffer aside until the shared one is released
+                dataSize = size;
+                ownReadBuf = readBuf;
+                readBuf = data;
+                sharedOwner = owner;
+                if (latencyProbe) { latencyProbe->record(writeMeta); }
+                readMeta = writeMeta;
+                writeMeta.clear();
                 canSwap = false;
             }
 
@@ -63,16 +146,38 @@ namespace dsp {
                 dataReady = true;
             }
             rdyCV.notify_all();
+            scheduler::notify();
 
             return true;
         }
 
+        // Number of samples readBuf can hold, only meaningful to the reader between read() and flush()
+        virtual int getReadCapacity() {
+            return sharedOwner ? 0 : readCap;
+        }
+
+        // Take readBuf away from the reader so that its data can be kept past flush(), giving it the buffer
+        // passed in exchange, which must be at least as large. Must be called by the reader between read() and flush().
+        // Fails if readBuf isn't the stream's own, the caller then has to copy the data.
+        virtual bool exchangeReadBuf(T*& buf, int& cap) {
+            if (sharedOwner || cap < readCap) { return false; }
+            std::swap(readBuf, buf);
+            std::swap(readCap, cap);
+            return true;
+        }
+
         virtual inline int read() {
+            profiler::Wait wait(profiler::STAGE_READ);
+
             // Wait for data to be ready or to be stopped
             std::unique_lock<std::mutex> lck(rdyMtx);
             rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            if (readerStop) { return -1; }
 
-            return (readerStop ? -1 : dataSize);
+            // Reading the same data more than once until it's flushed is allowed, only count it once
+            if (readSeen) { return dataSize; }
+            readSeen = true;
+            return wait.samples(dataSize);
         }
 
         virtual inline void flush() {
@@ -81,6 +186,10 @@ namespace dsp {
                 std::lock_guard<std::mutex> lck(rdyMtx);
                 dataReady = false;
             }
+            readSeen = false;
+
+            // Give back the shared buffer, if any
+            releaseShared();
 
             // Notify writer that buffers can be swapped
             {
@@ -89,6 +198,7 @@ namespace dsp {
             }
 
             swapCV.notify_all();
+            scheduler::notify();
         }
 
         virtual void stopWriter() {
@@ -115,28 +225,94 @@ namespace dsp {
             readerStop = false;
         }
 
-        void free() {
-            if (writeBuf) { buffer::free(writeBuf); }
-            if (readBuf) { buffer::free(readBuf); }
+        virtual bool readable() {
+            return dataReady || readerStop;
+        }
+
+        virtual bool writable() {
+            return canSwap || writerStop;
+        }
+
+        virtual void free() {
+            releaseShared();
+            if (writeBuf) { freeBuffer(writeBuf, writeCap); }
+            if (readBuf) { freeBuffer(readBuf, readCap); }
             writeBuf = NULL;
             readBuf = NULL;
+            writeCap = 0;
+            readCap = 0;
         }
 
-        T* writeBuf;
-        T* readBuf;
+        T* writeBuf = NULL;
+        T* readBuf = NULL;
+
+        // Description of the data in writeBuf and readBuf, handed over to the reader along with the buffer
+        Metadata writeMeta;
+        Metadata readMeta;
+
+        // Register it with overflow::add() to have it show up in the reports
+        overflow::Counters overflow;
+
+        // Records the latency of the blocks handed over to the reader, not owned by the stream
+        latency::Probe* latencyProbe = NULL;
+
+    protected:
+        // Allows derived streams to manage their own buffers, no allocation is done if samples is zero
+        stream(int samples) {
+            if (!samples) { return; }
+            writeBuf = allocBuffer(samples);
+            readBuf = allocBuffer(samples);
+            writeCap = samples;
+            readCap = samples;
+        }
+
+        // Stream buffers go through these so that they show up in the memory report
+        static T* allocBuffer(int samples) {
+            buffer::track(buffer::USAGE_STREAM, (int64_t)samples * sizeof(T), 1);
+            return buffer::alloc<T>(samples);
+        }
+
+        static void freeBuffer(T* buf, int samples) {
+            buffer::track(buffer::USAGE_STREAM, -(int64_t)samples * sizeof(T), -1);
+            buffer::free(buf);
+        }
+
+        void resizeWriteBuf(int samples) {
+            freeBuffer(writeBuf, writeCap);
+            writeBuf = allocBuffer(samples);
+            writeCap = samples;
+        }
+
+        // Capacity of writeBuf and readBuf, they follow the buffers when swapped
+        int writeCap = 0;
+        int readCap = 0;
+
+        // Set once the reader got the current data, only ever touched by the reader
+        bool readSeen = false;
 
     private:
+        inline void releaseShared() {
+            if (!sharedOwner) { return; }
+            readBuf = ownReadBuf;
+            ownReadBuf = NULL;
+            sharedOwner.reset();
+        }
+
         std::mutex swapMtx;
         std::condition_variable swapCV;
-        bool canSwap = true;
+        std::atomic<bool> canSwap = true;
 
         std::mutex rdyMtx;
         std::condition_variable rdyCV;
-        bool dataReady = false;
+        std::atomic<bool> dataReady = false;
 
-        bool readerStop = false;
-        bool writerStop = false;
+        std::atomic<bool> readerStop = false;
+        std::atomic<bool> writerStop = false;
 
         int dataSize = 0;
+
+        // Shared buffer currently handed to the reader
+        T* ownReadBuf = NULL;
+        std::shared_ptr<void> sharedOwner;
     };
 }
\ No newline at end of file
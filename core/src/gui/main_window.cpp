@@ -27,6 +27,10 @@
 #include <gui/colormaps.h>
 #include <gui/widgets/snr_meter.h>
 #include <gui/tuner.h>
+#include <dsp/profiler.h>
+#include <dsp/buffer/buffer.h>
+#include <dsp/overflow.h>
+#include <dsp/latency.h>
 
 void MainWindow::init() {
     LoadingScreen::show("Initializing UI");
@@ -538,6 +542,122 @@ void MainWindow::draw() {
             ImGui::Checkbox("WF Single Click", &gui::waterfall.VFOMoveSingleClick);
             ImGui::Checkbox("Lock Menu Order", &gui::menu.locked);
 
+            bool profiling = dsp::profiler::isEnabled();
+            if (ImGui::Checkbox("DSP Profiling", &profiling)) {
+                dsp::profiler::setEnabled(profiling);
+            }
+            if (profiling) {
+                ImGui::SameLine();
+                if (ImGui::Button("Reset##_dsp_prof_reset")) { dsp::profiler::reset(); }
+                if (ImGui::BeginTable("DSP Profiling Table", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 300))) {
+                    ImGui::TableSetupColumn("Block");
+                    ImGui::TableSetupColumn("Load");
+                    ImGui::TableSetupColumn("Wait R/W");
+                    ImGui::TableSetupColumn("MS/s");
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+                    for (const auto& info : dsp::profiler::snapshot()) {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::TextUnformatted(info.name.c_str());
+                        if (ImGui::IsItemHovered()) { ImGui::SetTooltip("%s (%p)", info.name.c_str(), info.id); }
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%.1f%%", info.load * 100.0);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%.1f/%.1fs", info.readWait, info.swapWait);
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.2f", info.inRate * 1e-6);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+
+            dsp::buffer::UsageStats streamMem = dsp::buffer::getUsage(dsp::buffer::USAGE_STREAM);
+            dsp::buffer::UsageStats workMem = dsp::buffer::getUsage(dsp::buffer::USAGE_WORK);
+            ImGui::Text("Stream buffers: %.1f MB (%d)", (double)streamMem.bytes / 1048576.0, (int)streamMem.buffers);
+            ImGui::Text("Work buffers: %.1f MB (%d)", (double)workMem.bytes / 1048576.0, (int)workMem.buffers);
+            dsp::buffer::PoolStats pool = dsp::buffer::getPoolStats();
+            ImGui::Text("Buffer pool: %.1f MB cached, %.1f MB hugepages, %.1f MB advised THP", (double)pool.cachedBytes / 1048576.0, (double)pool.hugePageBytes / 1048576.0, (double)pool.thpBytes / 1048576.0);
+            ImGui::SameLine();
+            if (ImGui::Button("Trim##_dsp_pool_trim")) { dsp::buffer::trimPool(); }
+
+            auto overflows = dsp::overflow::snapshot();
+            if (!overflows.empty() && ImGui::TreeNode("Overruns and Drops")) {
+                if (ImGui::Button("Reset##_dsp_overflow_reset")) { dsp::overflow::reset(); }
+                int64_t now = dsp::overflow::wallTime();
+                if (ImGui::BeginTable("Overflow Table", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Stream");
+                    ImGui::TableSetupColumn("Overruns");
+                    ImGui::TableSetupColumn("Dropped");
+                    ImGui::TableSetupColumn("Last drop");
+                    ImGui::TableHeadersRow();
+                    for (const auto& info : overflows) {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::TextUnformatted(info.name.c_str());
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%llu", (unsigned long long)info.overruns);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%llu", (unsigned long long)info.droppedSamples);
+                        ImGui::TableSetColumnIndex(3);
+                        if (info.lastDrop) {
+                            ImGui::Text("%.1fs ago", (double)(now - info.lastDrop) / 1000.0);
+                        }
+                        else {
+                            ImGui::TextUnformatted("Never");
+                        }
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::TreePop();
+            }
+
+            bool tracing = dsp::latency::isEnabled();
+            if (ImGui::Checkbox("Latency Tracing", &tracing)) {
+                dsp::latency::setEnabled(tracing);
+            }
+            if (tracing) {
+                ImGui::SameLine();
+                if (ImGui::Button("Reset##_dsp_latency_reset")) { dsp::latency::reset(); }
+                auto latencies = dsp::latency::snapshot();
+                if (ImGui::BeginTable("Latency Table", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Probe");
+                    ImGui::TableSetupColumn("Stage");
+                    ImGui::TableSetupColumn("Median");
+                    ImGui::TableSetupColumn("P99");
+                    ImGui::TableSetupColumn("Max");
+                    ImGui::TableHeadersRow();
+                    for (const auto& info : latencies) {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::TextUnformatted((std::string(2 * info.depth, ' ') + info.name).c_str());
+                        if (ImGui::IsItemHovered()) {
+                            // Histogram of the latency up to this probe
+                            std::vector<float> hist(info.histogram.begin(), info.histogram.end());
+                            ImGui::BeginTooltip();
+                            ImGui::PlotHistogram("##_dsp_latency_hist", hist.data(), hist.size(), 0, NULL, 0.0f, FLT_MAX, ImVec2(300, 80));
+                            ImGui::Text("Log scale, %.1f ms to %.0f ms", dsp::latency::BUCKET_FIRST_MS, dsp::latency::bucketEdge(dsp::latency::BUCKET_COUNT - 1));
+                            ImGui::EndTooltip();
+                        }
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%+.1f ms", info.stage);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%.1f ms", info.p50);
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.1f ms", info.p99);
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%.1f ms", info.max);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+
+            std::string policies = threading::getPolicyReport();
+            if (!policies.empty() && ImGui::TreeNode("Thread Policies")) {
+                ImGui::TextUnformatted(policies.c_str());
+                ImGui::TreePop();
+            }
+
             ImGui::Spacing();
         }
 
@@ -14,6 +14,8 @@ namespace sourcemenu {
     int decimationPower = 0;
     bool iqCorrection = false;
     bool invertIQ = false;
+    bool channelizer = false;
+    bool sharedDecimation = false;
 
     EventHandler<std::string> sourceRegisteredHandler;
     EventHandler<std::string> sourceUnregisterHandler;
@@ -145,8 +147,12 @@ namespace sourcemenu {
         decimationPower = core::configManager.conf["decimationPower"];
         iqCorrection = core::configManager.conf["iqCorrection"];
         invertIQ = core::configManager.conf["invertIQ"];
+        channelizer = core::configManager.conf["channelizer"];
+        sharedDecimation = core::configManager.conf["sharedDecimation"];
         sigpath::iqFrontEnd.setDCBlocking(iqCorrection);
         sigpath::iqFrontEnd.setInvertIQ(invertIQ);
+        sigpath::iqFrontEnd.setChannelizer(channelizer);
+        sigpath::iqFrontEnd.setSharedDecimation(sharedDecimation);
         updateOffset();
 
         refreshSources();
@@ -195,6 +201,20 @@ namespace sourcemenu {
             core::configManager.release(true);
         }
 
+        if (ImGui::Checkbox("Channelize VFOs##_sdrpp_channelizer", &channelizer)) {
+            sigpath::iqFrontEnd.setChannelizer(channelizer);
+            core::configManager.acquire();
+            core::configManager.conf["channelizer"] = channelizer;
+            core::configManager.release(true);
+        }
+
+        if (ImGui::Checkbox("Share VFO decimation##_sdrpp_shared_decim", &sharedDecimation)) {
+            sigpath::iqFrontEnd.setSharedDecimation(sharedDecimation);
+            core::configManager.acquire();
+            core::configManager.conf["sharedDecimation"] = sharedDecimation;
+            core::configManager.release(true);
+        }
+
         ImGui::LeftLabel("Offset mode");
         ImGui::SetNextItemWidth(itemWidth - ImGui::GetCursorPosX());
         if (ImGui::Combo("##_sdrpp_offset_mode", &offsetMode, offsetModesTxt)) {
@@ -6,6 +6,7 @@
 IQFrontEnd::~IQFrontEnd() {
     if (!_init) { return; }
     stop();
+    if (channelizerIn) { delete channelizerIn; }
     dsp::buffer::free(fftWindowBuf);
     fftwf_destroy_plan(fftwPlan);
     fftwf_free(fftInBuf);
@@ -26,6 +27,12 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
 
     inBuf.init(in);
     inBuf.bypass = !buffering;
+    dsp::overflow::add("IQ frontend buffer", &inBuf.overflow);
+    dsp::overflow::add("IQ frontend DSP", &inBuf.out.overflow);
+    dsp::latency::add("IQ frontend buffer", &bufferLatency);
+    dsp::latency::add("IQ frontend DSP", &dspLatency, "IQ frontend buffer");
+    dsp::latency::add("IQ frontend channelizer", &channelizerLatency, "IQ frontend DSP");
+    inBuf.out.latencyProbe = &bufferLatency;
 
     decim.init(NULL, _decimRatio);
     dcBlock.init(NULL, genDCBlockRate(effectiveSr));
@@ -35,9 +42,13 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     preproc.addBlock(&decim, _decimRatio > 1);
     preproc.addBlock(&dcBlock, dcBlocking);
     preproc.addBlock(&conjugate, false); // TODO: Replace by parameter
+    preproc.setLatencyProbe(&dspLatency);
 
     split.init(preproc.out);
 
+    // None of the consumers write to their input, so they can all read the same block
+    split.setShared(true);
+
     // TODO: Do something to avoid basically repeating this code twice
     int skip;
     genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, _nzFFTSize);
@@ -56,6 +67,11 @@ void IQFrontEnd::setInput(dsp::stream<dsp::complex_t>* in) {
 }
 
 void IQFrontEnd::setSampleRate(double sampleRate) {
+    // Regions are laid out for the old samplerate, their VFOs go back to the full band until they're rebuilt
+    for (auto& [name, vfo] : vfos) {
+        if (vfoRoutes[name].source == VFO_SOURCE_REGION) { moveVFO(name, VFORoute(), vfoOffsets[name]); }
+    }
+
     // Temp stop the necessary blocks
     dcBlock.tempStop();
     for (auto& [name, vfo] : vfos) {
@@ -66,8 +82,10 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
     _sampleRate = sampleRate;
     effectiveSr = _sampleRate / _decimRatio;
     dcBlock.setRate(genDCBlockRate(effectiveSr));
+    if (_channelizer) { channelizer.setChannelCount(genChannelCount(effectiveSr)); }
+    regionCount = genRegionCount(effectiveSr);
     for (auto& [name, vfo] : vfos) {
-        vfo->setInSamplerate(effectiveSr);
+        vfo->setInSamplerate(getRouteSamplerate(vfoRoutes[name]));
     }
 
     // Reconfigure the FFT
@@ -78,6 +96,11 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
     for (auto& [name, vfo] : vfos) {
         vfo->tempStart();
     }
+
+    // The channels and regions moved, find the new one of each VFO
+    if (_channelizer || _sharedDecimation) {
+        for (auto& [name, vfo] : vfos) { routeVFO(name); }
+    }
 }
 
 void IQFrontEnd::setBuffering(bool enabled) {
@@ -126,18 +149,31 @@ dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, dou
         return NULL;
     }
 
-    // Create VFO and its input stream
-    dsp::stream<dsp::complex_t>* vfoIn = new dsp::stream<dsp::complex_t>;
+    // Create VFO and its input stream, queued so that one slow VFO doesn't stall the whole splitter.
+    // Its buffers start small, shared blocks don't need them and writers copying into them grow them as needed.
+    dsp::ring_stream<dsp::complex_t>* vfoIn = new dsp::ring_stream<dsp::complex_t>(VFO_QUEUE_SLOTS, STREAM_MIN_BUFFER_SIZE);
     dsp::channel::RxVFO* vfo = new dsp::channel::RxVFO(vfoIn, effectiveSr, sampleRate, bandwidth, offset);
 
     // Register them
     vfoStreams[name] = vfoIn;
     vfos[name] = vfo;
+    vfoOffsets[name] = offset;
+    vfoBandwidths[name] = bandwidth;
+    vfoRoutes[name] = VFORoute();
+
+    // Measured from whichever source feeds the VFO, the link is updated when it moves
+    dsp::latency::Probe* latency = new dsp::latency::Probe;
+    dsp::latency::add("VFO " + name, latency, "IQ frontend DSP");
+    vfo->out.latencyProbe = latency;
+    vfoLatency[name] = latency;
     bindIQStream(vfoIn);
 
     // Start VFO
     vfo->start();
 
+    // Move it to its channel or region if it fits in one
+    if (_channelizer || _sharedDecimation) { rerouteVFOs(name); }
+
     return vfo;
 }
 
@@ -149,19 +185,278 @@ void IQFrontEnd::removeVFO(std::string name) {
     }
 
     // Remove the VFO and stream from registry
-    dsp::stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    dsp::ring_stream<dsp::complex_t>* vfoIn = vfoStreams[name];
     dsp::channel::RxVFO* vfo = vfos[name];
 
     // Stop the VFO
     vfo->stop();
 
-    unbindIQStream(vfoIn);
+    detachVFO(name);
     vfoStreams.erase(name);
     vfos.erase(name);
+    vfoOffsets.erase(name);
+    vfoBandwidths.erase(name);
+    vfoRoutes.erase(name);
 
-    // Delete the VFO and its input stream
+    // Delete the VFO, its input stream and its probe
     delete vfo;
     delete vfoIn;
+    delete vfoLatency[name];
+    vfoLatency.erase(name);
+
+    // The region it was in might not be worth keeping anymore
+    if (_sharedDecimation) {
+        for (auto& [other, vfo] : vfos) { routeVFO(other, false); }
+    }
+}
+
+void IQFrontEnd::setVFOOffset(std::string name, double offset) {
+    if (vfos.find(name) == vfos.end()) {
+        flog::error("[IQFrontEnd] Tried to tune a VFO that doesn't exist.");
+        return;
+    }
+    vfoOffsets[name] = offset;
+    rerouteVFOs(name);
+}
+
+void IQFrontEnd::setVFOBandwidth(std::string name, double bandwidth) {
+    if (vfos.find(name) == vfos.end()) {
+        flog::error("[IQFrontEnd] Tried to change the bandwidth of a VFO that doesn't exist.");
+        return;
+    }
+    vfoBandwidths[name] = bandwidth;
+    vfos[name]->setBandwidth(bandwidth);
+    rerouteVFOs(name);
+}
+
+void IQFrontEnd::setVFOSampleRate(std::string name, double sampleRate, double bandwidth) {
+    if (vfos.find(name) == vfos.end()) {
+        flog::error("[IQFrontEnd] Tried to change the samplerate of a VFO that doesn't exist.");
+        return;
+    }
+    vfoBandwidths[name] = bandwidth;
+    vfos[name]->setOutSamplerate(sampleRate, bandwidth);
+    rerouteVFOs(name);
+}
+
+void IQFrontEnd::setChannelizer(bool enabled) {
+    if (enabled == _channelizer) { return; }
+    _channelizer = enabled;
+
+    // Bring up the channelizer before moving VFOs to it
+    if (enabled) {
+        int count = genChannelCount(effectiveSr);
+        if (!channelizerIn) {
+            channelizerIn = new dsp::ring_stream<dsp::complex_t>(VFO_QUEUE_SLOTS, STREAM_MIN_BUFFER_SIZE);
+            channelizer.init(channelizerIn, count);
+            channelizer.latencyProbe = &channelizerLatency;
+        }
+        else {
+            channelizer.setChannelCount(count);
+        }
+        bindIQStream(channelizerIn);
+        channelizer.start();
+        flog::info("[IQFrontEnd] Channelizer enabled with {0} channels", count);
+    }
+
+    for (auto& [name, vfo] : vfos) { routeVFO(name); }
+
+    // And only take it down once no VFO uses it anymore
+    if (!enabled) {
+        channelizer.stop();
+        unbindIQStream(channelizerIn);
+        drain(channelizerIn);
+    }
+}
+
+void IQFrontEnd::setSharedDecimation(bool enabled) {
+    if (enabled == _sharedDecimation) { return; }
+    _sharedDecimation = enabled;
+    regionCount = genRegionCount(effectiveSr);
+
+    // Regions are created on demand and go away along with their last VFO
+    for (auto& [name, vfo] : vfos) { routeVFO(name); }
+}
+
+bool IQFrontEnd::findChannel(double offset, double bandwidth, int& channel, double& delta) {
+    if (!_channelizer) { return false; }
+    channel = channelizer.nearestChannel(offset, effectiveSr);
+    delta = offset - channelizer.channelOffset(channel, effectiveSr);
+    return channelizer.fits(delta, bandwidth, effectiveSr);
+}
+
+bool IQFrontEnd::findRegion(double offset, double bandwidth, int& region, double& delta) {
+    if (!_sharedDecimation) { return false; }
+    double width = effectiveSr / (double)regionCount;
+    region = (int)round(offset / width);
+    delta = offset - (double)region * width;
+    return fabs(delta) + (bandwidth / 2.0) <= REGION_PASSBAND * width;
+}
+
+int IQFrontEnd::countRegionUsers(int region) {
+    int count = 0;
+    for (auto& [name, vfo] : vfos) {
+        int index;
+        double delta;
+        if (findChannel(vfoOffsets[name], vfoBandwidths[name], index, delta)) { continue; }
+        if (findRegion(vfoOffsets[name], vfoBandwidths[name], index, delta) && index == region) { count++; }
+    }
+    return count;
+}
+
+void IQFrontEnd::rerouteVFOs(const std::string& changed) {
+    routeVFO(changed);
+
+    // Whether a region is worth using depends on how many VFOs are in it, which the change might have affected
+    if (!_sharedDecimation) { return; }
+    for (auto& [name, vfo] : vfos) {
+        if (name != changed) { routeVFO(name, false); }
+    }
+}
+
+void IQFrontEnd::routeVFO(const std::string& name, bool retune) {
+    // Use the narrowest source the whole VFO fits in, the full band otherwise.
+    // A region costs about as much as a few VFOs tuned on their own, so it's only used once shared enough.
+    // Existing regions are kept with fewer users so that VFOs don't bounce between a region and the band.
+    VFORoute route;
+    int index;
+    double delta;
+    double offset = vfoOffsets[name];
+    if (findChannel(vfoOffsets[name], vfoBandwidths[name], index, delta)) {
+        route = { VFO_SOURCE_CHANNEL, index };
+        offset = delta;
+    }
+    else if (findRegion(vfoOffsets[name], vfoBandwidths[name], index, delta) && countRegionUsers(index) >= (regions.count(index) ? REGION_KEEP_USERS : REGION_MIN_USERS)) {
+        route = { VFO_SOURCE_REGION, index };
+        offset = delta;
+    }
+
+    // Same source, only the tuning changes
+    VFORoute& current = vfoRoutes[name];
+    if (route == current) {
+        if (retune) { vfos[name]->setOffset(offset); }
+        return;
+    }
+
+    // Channels all have the same samplerate, the VFO can be moved between them without being stopped
+    if (route.source == VFO_SOURCE_CHANNEL && current.source == VFO_SOURCE_CHANNEL) {
+        channelizer.setChannel(vfoStreams[name], route.index);
+        current = route;
+        vfos[name]->setOffset(offset);
+        return;
+    }
+
+    moveVFO(name, route, offset);
+}
+
+void IQFrontEnd::moveVFO(const std::string& name, const VFORoute& route, double offset) {
+    dsp::channel::RxVFO* vfo = vfos[name];
+
+    // Move the VFO to its new source, dropping what the old one had queued up
+    vfo->tempStop();
+    detachVFO(name);
+    drain(vfoStreams[name]);
+
+    vfo->setInSamplerate(getRouteSamplerate(route));
+    vfo->setOffset(offset);
+    vfo->reset();
+
+    attachVFO(name, route);
+    vfo->tempStart();
+}
+
+void IQFrontEnd::attachVFO(const std::string& name, const VFORoute& route) {
+    dsp::ring_stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    switch (route.source) {
+        case VFO_SOURCE_BAND:
+            bindIQStream(vfoIn);
+            dsp::latency::link("VFO " + name, "IQ frontend DSP");
+            break;
+        case VFO_SOURCE_CHANNEL:
+            channelizer.bindStream(vfoIn, route.index);
+            dsp::latency::link("VFO " + name, "IQ frontend channelizer");
+            break;
+        case VFO_SOURCE_REGION:
+            acquireRegion(route.index)->split.bindStream(vfoIn);
+            dsp::latency::link("VFO " + name, genRegionProbeName(route.index));
+            break;
+    }
+    vfoRoutes[name] = route;
+}
+
+void IQFrontEnd::detachVFO(const std::string& name) {
+    dsp::ring_stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    const VFORoute& route = vfoRoutes[name];
+    switch (route.source) {
+        case VFO_SOURCE_BAND:
+            unbindIQStream(vfoIn);
+            break;
+        case VFO_SOURCE_CHANNEL:
+            channelizer.unbindStream(vfoIn);
+            break;
+        case VFO_SOURCE_REGION:
+            regions[route.index]->split.unbindStream(vfoIn);
+            releaseRegion(route.index);
+            break;
+    }
+}
+
+double IQFrontEnd::getRouteSamplerate(const VFORoute& route) {
+    switch (route.source) {
+        case VFO_SOURCE_CHANNEL:
+            return channelizer.channelSamplerate(effectiveSr);
+        case VFO_SOURCE_REGION:
+            return 2.0 * effectiveSr / (double)regionCount;
+        default:
+            return effectiveSr;
+    }
+}
+
+IQFrontEnd::Region* IQFrontEnd::acquireRegion(int index) {
+    auto it = regions.find(index);
+    if (it != regions.end()) {
+        it->second->users++;
+        return it->second;
+    }
+
+    // Flat up to REGION_PASSBAND of the width and stopped from where aliases would fold back into that
+    double width = effectiveSr / (double)regionCount;
+    Region* region = new Region;
+    region->in = new dsp::ring_stream<dsp::complex_t>(VFO_QUEUE_SLOTS, STREAM_MIN_BUFFER_SIZE);
+    region->taps = dsp::taps::lowPass(width, (1.0 - REGION_PASSBAND) * 2.0 * width, effectiveSr, true);
+    region->ddc.init(region->in, region->taps, regionCount / 2, -(double)index * width, effectiveSr);
+    region->split.init(&region->ddc.out);
+    dsp::latency::add(genRegionProbeName(index), &region->latency, "IQ frontend DSP");
+    region->ddc.out.latencyProbe = &region->latency;
+    region->split.setShared(true);
+    region->users = 1;
+    regions[index] = region;
+
+    bindIQStream(region->in);
+    region->ddc.start();
+    region->split.start();
+    flog::debug("[IQFrontEnd] Created region {0} ({1} Hz wide, {2} taps)", index, width, region->taps.size);
+
+    return region;
+}
+
+void IQFrontEnd::releaseRegion(int index) {
+    Region* region = regions[index];
+    if (--region->users) { return; }
+
+    region->split.stop();
+    region->ddc.stop();
+    unbindIQStream(region->in);
+    drain(region->in);
+    regions.erase(index);
+
+    delete region->in;
+    dsp::taps::free(region->taps);
+    delete region;
+}
+
+void IQFrontEnd::drain(dsp::ring_stream<dsp::complex_t>* stream) {
+    while (stream->getQueuedCount()) { stream->flush(); }
 }
 
 void IQFrontEnd::setFFTSize(int size) {
@@ -193,7 +488,12 @@ void IQFrontEnd::start() {
     // Start IQ splitter
     split.start();
 
-    // Start all VFOs
+    // Start the channelizer, regions and all VFOs
+    if (_channelizer) { channelizer.start(); }
+    for (auto& [index, region] : regions) {
+        region->ddc.start();
+        region->split.start();
+    }
     for (auto& [name, vfo] : vfos) {
         vfo->start();
     }
@@ -213,7 +513,12 @@ void IQFrontEnd::stop() {
     // Stop IQ splitter
     split.stop();
 
-    // Stop all VFOs
+    // Stop the channelizer, regions and all VFOs
+    if (_channelizer) { channelizer.stop(); }
+    for (auto& [index, region] : regions) {
+        region->split.stop();
+        region->ddc.stop();
+    }
     for (auto& [name, vfo] : vfos) {
         vfo->stop();
     }
@@ -4,8 +4,11 @@
 #include "../dsp/multirate/power_decimator.h"
 #include "../dsp/correction/dc_blocker.h"
 #include "../dsp/chain.h"
+#include "../dsp/ring_stream.h"
 #include "../dsp/routing/splitter.h"
 #include "../dsp/channel/rx_vfo.h"
+#include "../dsp/channel/pfb_channelizer.h"
+#include "../dsp/filter/freq_xlating_decimating_fir.h"
 #include "../dsp/sink/handler_sink.h"
 #include "../dsp/math/conjugate.h"
 #include "../dsp/window/window.h"
@@ -34,6 +37,19 @@ public:
     dsp::channel::RxVFO* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
     void removeVFO(std::string name);
 
+    // VFOs must be retuned through these so that they're moved to the right channel or region
+    void setVFOOffset(std::string name, double offset);
+    void setVFOBandwidth(std::string name, double bandwidth);
+    void setVFOSampleRate(std::string name, double sampleRate, double bandwidth);
+
+    // In channelizer mode, a single polyphase filterbank splits the band into channels and every VFO narrow
+    // enough to fit in one is fed from the nearest, so that its own work happens at the channel rate
+    void setChannelizer(bool enabled);
+
+    // With shared decimation, the band is split into regions translated and decimated once for all the VFOs
+    // they contain, each VFO then only does the last narrow stages of its own resampling
+    void setSharedDecimation(bool enabled);
+
     void setFFTSize(int size);
     void setFFTRate(double rate);
     void setFFTWindow(dsp::window::windowType fftWindow);
@@ -53,6 +69,90 @@ protected:
         return 50.0 / sampleRate;
     }
 
+    // Channels are made as narrow as possible while staying at least this wide
+    static constexpr double CHANNELIZER_MIN_SPACING = 25000.0;
+    static const int CHANNELIZER_MIN_CHANNELS = 4;
+    static const int CHANNELIZER_MAX_CHANNELS = 1024;
+
+    static inline int genChannelCount(double sampleRate) {
+        int count = CHANNELIZER_MIN_CHANNELS;
+        while (count < CHANNELIZER_MAX_CHANNELS && sampleRate / (double)(count * 2) >= CHANNELIZER_MIN_SPACING) { count *= 2; }
+        return count;
+    }
+
+    // Regions are made as narrow as possible while staying at least this wide
+    static constexpr double REGION_MIN_WIDTH = 200000.0;
+    static const int REGION_MIN_COUNT = 4;
+    static const int REGION_MAX_COUNT = 256;
+
+    // Fraction of the region width around its center passed without attenuation or aliasing
+    static constexpr double REGION_PASSBAND = 0.75;
+
+    // VFOs needed in a region before it gets used instead of having each of them work from the full band,
+    // and below which a region in use is given up. The gap keeps a VFO moving in and out of a region
+    // from having the region created and destroyed along with all the VFOs in it being moved every time.
+    static const int REGION_MIN_USERS = 3;
+    static const int REGION_KEEP_USERS = REGION_MIN_USERS - 1;
+
+    static inline int genRegionCount(double sampleRate) {
+        int count = REGION_MIN_COUNT;
+        while (count < REGION_MAX_COUNT && sampleRate / (double)(count * 2) >= REGION_MIN_WIDTH) { count *= 2; }
+        return count;
+    }
+
+    // Where a VFO gets its samples from, index being the channel or region number
+    enum VFOSource {
+        VFO_SOURCE_BAND,
+        VFO_SOURCE_CHANNEL,
+        VFO_SOURCE_REGION
+    };
+
+    struct VFORoute {
+        VFOSource source = VFO_SOURCE_BAND;
+        int index = 0;
+
+        bool operator==(const VFORoute& b) const { return source == b.source && index == b.index; }
+    };
+
+    // Part of the band translated and decimated by a single filter, with its output shared by all the VFOs in it.
+    // Regions are spaced by their width and come out at twice that, so that they overlap by half.
+    struct Region {
+        dsp::ring_stream<dsp::complex_t>* in;
+        dsp::tap<float> taps;
+        dsp::filter::FreqXlatingDecimatingFIR ddc;
+        dsp::routing::Splitter<dsp::complex_t> split;
+        dsp::latency::Probe latency;
+        int users = 0;
+    };
+
+    // Channel or region a VFO fits in and its offset from the center of it
+    bool findChannel(double offset, double bandwidth, int& channel, double& delta);
+    bool findRegion(double offset, double bandwidth, int& region, double& delta);
+    int countRegionUsers(int region);
+
+    // Feed a VFO from the narrowest source it fits in, the full band otherwise, and tune it accordingly.
+    // Without retune, the VFO is only touched if it has to move to another source.
+    void routeVFO(const std::string& name, bool retune = true);
+    void rerouteVFOs(const std::string& changed);
+    void moveVFO(const std::string& name, const VFORoute& route, double offset);
+    void attachVFO(const std::string& name, const VFORoute& route);
+    void detachVFO(const std::string& name);
+    double getRouteSamplerate(const VFORoute& route);
+
+    // Regions only exist while VFOs use them
+    Region* acquireRegion(int index);
+    void releaseRegion(int index);
+
+    static inline std::string genRegionProbeName(int index) {
+        return "IQ frontend region " + std::to_string(index);
+    }
+
+    // Release the blocks still queued in a stream that was just unbound from its writer
+    static void drain(dsp::ring_stream<dsp::complex_t>* stream);
+
+    // Number of blocks that can be queued for each VFO before the splitter has to wait on it
+    static const int VFO_QUEUE_SLOTS = 4;
+
     static inline void genReshapeParams(double sampleRate, int size, double rate, int& skip, int& nzSampCount) {
         int fftInterval = round(sampleRate / rate);
         nzSampCount = std::min<int>(fftInterval, size);
@@ -77,9 +177,30 @@ protected:
     dsp::sink::Handler<dsp::complex_t> fftSink;
 
     // VFOs
-    std::map<std::string, dsp::stream<dsp::complex_t>*> vfoStreams;
+    std::map<std::string, dsp::ring_stream<dsp::complex_t>*> vfoStreams;
     std::map<std::string, dsp::channel::RxVFO*> vfos;
 
+    // Offset and bandwidth of each VFO and where it gets its samples from
+    std::map<std::string, double> vfoOffsets;
+    std::map<std::string, double> vfoBandwidths;
+    std::map<std::string, VFORoute> vfoRoutes;
+
+    // Channelizer, only created once first enabled
+    dsp::ring_stream<dsp::complex_t>* channelizerIn = NULL;
+    dsp::channel::PFBChannelizer channelizer;
+    bool _channelizer = false;
+
+    // Shared decimation
+    std::map<int, Region*> regions;
+    int regionCount = REGION_MIN_COUNT;
+    bool _sharedDecimation = false;
+
+    // Latency of the blocks coming out of the input buffer, the DSP, the channelizer and each VFO (regions have their own)
+    dsp::latency::Probe bufferLatency;
+    dsp::latency::Probe dspLatency;
+    dsp::latency::Probe channelizerLatency;
+    std::map<std::string, dsp::latency::Probe*> vfoLatency;
+
     // Parameters
     double _sampleRate;
     double _decimRatio;
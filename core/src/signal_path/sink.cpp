@@ -26,6 +26,7 @@ void SinkManager::Stream::init(dsp::stream<dsp::stereo_t>* in, EventHandler<floa
     splitter.bindStream(&volumeInput);
     volumeAjust.init(&volumeInput, 1.0f, false);
     sinkOut = &volumeAjust.out;
+    sinkOut->latencyProbe = &latency;
 }
 
 void SinkManager::Stream::start() {
@@ -164,6 +165,7 @@ void SinkManager::registerStream(std::string name, SinkManager::Stream* stream)
 
     streams[name] = stream;
     streamNames.push_back(name);
+    dsp::latency::add("Sink stream " + name, &stream->latency);
 
     // Load config
     core::configManager.acquire();
@@ -183,6 +185,7 @@ void SinkManager::unregisterStream(std::string name) {
     SinkManager::Stream* stream = streams[name];
     stream->stop();
     delete stream->sink;
+    dsp::latency::remove(&stream->latency);
     streams.erase(name);
     streamNames.erase(std::remove(streamNames.begin(), streamNames.end(), name), streamNames.end());
     onStreamUnregistered.emit(name);
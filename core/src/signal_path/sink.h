@@ -56,6 +56,7 @@ public:
         SinkManager::Sink* sink;
         dsp::stream<dsp::stereo_t> volumeInput;
         dsp::audio::Volume volumeAjust;
+        dsp::latency::Probe latency;
         std::mutex ctrlMtx;
         float _sampleRate;
         int providerId = 0;
@@ -20,7 +20,9 @@
     #include <sys/prctl.h>
     #include <unistd.h>
     #include <sys/syscall.h>
+    #include <sys/resource.h>
     #include <pthread.h>
+    #include <sched.h>
 #elif defined(__APPLE__)
     #include <pthread.h>
 #elif defined(_WIN32)
@@ -31,10 +33,16 @@
 #include <thread>
 #include <atomic>
 #include <fstream>
+#include <mutex>
+#include <map>
+#include <string.h>
+#include <errno.h>
 
 
 namespace threading {
 
+    static void applyPolicy(const std::string& name);
+
     void sleep(int32_t millisecondsTimeout) {
         std::this_thread::sleep_for(std::chrono::milliseconds(millisecondsTimeout));
     }
@@ -52,6 +60,7 @@ namespace threading {
     void thread::onStarted(const std::string& name) {
         threading::getThreadHash();
         threading::setThreadName(name);
+        applyPolicy(name);
         //flog::debug("thread {:x} {} started", threading::getThreadHash(), name);
     }
     void thread::onFinished(const std::string& name) {
@@ -256,4 +265,158 @@ namespace threading {
         return t_threadName;
     }
 #endif
+
+
+//----------------------------------------------------------------------
+// Thread policies
+
+    struct PolicyResult {
+        std::string pattern;
+        std::string result;
+        int count = 0;
+    };
+
+    // Function local so that threads started during static initialization are fine
+    static std::mutex& policyMtx() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static std::vector<ThreadPolicy>& policies() {
+        static std::vector<ThreadPolicy> pols;
+        return pols;
+    }
+
+    static std::map<std::string, PolicyResult>& policyResults() {
+        static std::map<std::string, PolicyResult> results;
+        return results;
+    }
+
+    static bool matchPattern(const char* pattern, const char* str) {
+        for (; *pattern; pattern++, str++) {
+            if (*pattern == '*') {
+                // Try to match the rest of the pattern at every position
+                for (; *str; str++) {
+                    if (matchPattern(pattern + 1, str)) { return true; }
+                }
+                return matchPattern(pattern + 1, str);
+            }
+            if (!*str || (*pattern != '?' && *pattern != *str)) { return false; }
+        }
+        return !*str;
+    }
+
+    static std::string errorString(int err) {
+        return std::string("failed (") + strerror(err) + ")";
+    }
+
+    static std::string applyAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+        return err ? errorString(err) : "ok";
+#elif defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < (int)(sizeof(DWORD_PTR) * 8)) { mask |= (DWORD_PTR)1 << cpu; }
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), mask) ? "ok" : "failed";
+#else
+        return "not supported";
+#endif
+    }
+
+    static std::string applyScheduling(Scheduling scheduling, int priority) {
+#if defined(__linux__) || defined(__APPLE__)
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int err = pthread_setschedparam(pthread_self(), (scheduling == SCHEDULING_FIFO) ? SCHED_FIFO : SCHED_RR, &param);
+        return err ? errorString(err) : "ok";
+#elif defined(_WIN32)
+        // Windows has no real-time policies for threads, use its highest priority instead
+        return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) ? "ok" : "failed";
+#else
+        return "not supported";
+#endif
+    }
+
+    static std::string applyNice(int nice) {
+#if defined(__linux__)
+        // On Linux, the nice value is per thread
+        if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice)) { return errorString(errno); }
+        return "ok";
+#elif defined(_WIN32)
+        int prio = THREAD_PRIORITY_NORMAL;
+        if (nice <= -10) { prio = THREAD_PRIORITY_HIGHEST; }
+        else if (nice < 0) { prio = THREAD_PRIORITY_ABOVE_NORMAL; }
+        else if (nice >= 10) { prio = THREAD_PRIORITY_LOWEST; }
+        else if (nice > 0) { prio = THREAD_PRIORITY_BELOW_NORMAL; }
+        return SetThreadPriority(GetCurrentThread(), prio) ? "ok" : "failed";
+#else
+        return "not supported";
+#endif
+    }
+
+    static void applyPolicy(const std::string& name) {
+        // Find the first matching policy
+        ThreadPolicy pol;
+        {
+            std::lock_guard<std::mutex> lck(policyMtx());
+            bool found = false;
+            for (const auto& p : policies()) {
+                if (!matchPattern(p.pattern.c_str(), name.c_str())) { continue; }
+                pol = p;
+                found = true;
+                break;
+            }
+            if (!found) { return; }
+        }
+
+        // Apply it to the calling thread
+        std::string result;
+        if (!pol.cpus.empty()) {
+            std::string cpus;
+            for (int cpu : pol.cpus) { cpus += (cpus.empty() ? "" : ",") + std::to_string(cpu); }
+            result += "cpus " + cpus + " " + applyAffinity(pol.cpus);
+        }
+        if (pol.scheduling != SCHEDULING_DEFAULT) {
+            if (!result.empty()) { result += ", "; }
+            result += std::string((pol.scheduling == SCHEDULING_FIFO) ? "fifo " : "rr ") + std::to_string(pol.priority) + " " + applyScheduling(pol.scheduling, pol.priority);
+        }
+        if (pol.setNice) {
+            if (!result.empty()) { result += ", "; }
+            result += "nice " + std::to_string(pol.nice) + " " + applyNice(pol.nice);
+        }
+
+        // Record the outcome, warning only the first time a thread name fails
+        bool warn = false;
+        {
+            std::lock_guard<std::mutex> lck(policyMtx());
+            PolicyResult& res = policyResults()[name];
+            warn = (result.find("failed") != std::string::npos) && (res.count == 0 || res.result != result);
+            res.pattern = pol.pattern;
+            res.result = result;
+            res.count++;
+        }
+        if (warn) { flog::warn("Could not fully apply thread policy '{}' to thread '{}': {}", pol.pattern, name, result); }
+    }
+
+    void setThreadPolicies(const std::vector<ThreadPolicy>& pols) {
+        std::lock_guard<std::mutex> lck(policyMtx());
+        policies() = pols;
+    }
+
+    std::string getPolicyReport() {
+        std::lock_guard<std::mutex> lck(policyMtx());
+        std::string report;
+        for (const auto& [name, res] : policyResults()) {
+            report += name + " x" + std::to_string(res.count) + " (" + res.pattern + "): " + res.result + "\n";
+        }
+        return report;
+    }
 }
@@ -18,6 +18,7 @@
 #include <string>
 #include <thread>
 #include <functional>
+#include <vector>
 #include <stdint.h>
 #include <utils/flog.h>
 
@@ -30,6 +31,28 @@ namespace threading {
 
     void setThreadName(const std::string &name);
     std::string getThreadName();
+
+    enum Scheduling {
+        SCHEDULING_DEFAULT,
+        SCHEDULING_FIFO,
+        SCHEDULING_RR
+    };
+
+    // Placement and priority of the threads whose name matches the pattern ('*' and '?' wildcards).
+    // Only the first matching policy is applied, when the thread starts.
+    struct ThreadPolicy {
+        std::string pattern;
+        std::vector<int> cpus;      // Empty to leave the affinity alone
+        Scheduling scheduling = SCHEDULING_DEFAULT;
+        int priority = 0;           // Real-time priority when using FIFO or RR scheduling
+        bool setNice = false;
+        int nice = 0;
+    };
+
+    void setThreadPolicies(const std::vector<ThreadPolicy>& policies);
+
+    // What was applied to the threads started so far, one line per thread name
+    std::string getPolicyReport();
     
 
     class thread {
@@ -1,5 +1,6 @@
 #pragma once
 #include <dsp/loop/pll.h>
+#include <dsp/kernel/nco.h>
 #include "chrominance_filter.h"
 
 // TODO: Should be 60 but had to try something
@@ -20,43 +21,37 @@ namespace dsp::loop {
         }
 
         inline int process(int count, complex_t* in, complex_t* out, bool aphase = false) {
-            // Process the pre-burst section
-            for (int i = 0; i < BURST_START; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
-                pcl.advancePhase();
-            }
+            // Process the pre-burst section, the loop is open so the oscillator runs on its own
+            kernel::ncoMix(out, in, BURST_START, pcl.phase, pcl.freq);
+            pcl.advancePhase(BURST_START);
 
             // Process the burst itself
             if (aphase) {
                 for (int i = BURST_START; i < BURST_END; i++) {
-                    complex_t outVal = in[i] * math::phasor(-pcl.phase);
+                    complex_t outVal = in[i] * math::fastPhasor(-pcl.phase);
                     out[i] = outVal;
-                    pcl.advance(math::normalizePhase(outVal.phase() - A_PHASE));
+                    pcl.advance(math::normalizePhase(math::polyAtan2<math::ATAN2_ACCURACY_HIGH>(outVal.im, outVal.re) - A_PHASE));
                 }
             }
             else {
                 for (int i = BURST_START; i < BURST_END; i++) {
-                    complex_t outVal = in[i] * math::phasor(-pcl.phase);
+                    complex_t outVal = in[i] * math::fastPhasor(-pcl.phase);
                     out[i] = outVal;
-                    pcl.advance(math::normalizePhase(outVal.phase() - B_PHASE));
+                    pcl.advance(math::normalizePhase(math::polyAtan2<math::ATAN2_ACCURACY_HIGH>(outVal.im, outVal.re) - B_PHASE));
                 }
             }
             
             
             // Process the post-burst section
-            for (int i = BURST_END; i < count; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
-                pcl.advancePhase();
-            }
+            kernel::ncoMix(&out[BURST_END], &in[BURST_END], count - BURST_END, pcl.phase, pcl.freq);
+            pcl.advancePhase(count - BURST_END);
 
             return count;
         }
 
         inline int processBlank(int count, complex_t* in, complex_t* out) {
-            for (int i = 0; i < count; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
-                pcl.advancePhase();
-            }
+            kernel::ncoMix(out, in, count, pcl.phase, pcl.freq);
+            pcl.advancePhase(count);
             return count;
         }
     };
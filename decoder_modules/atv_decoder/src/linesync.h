@@ -86,6 +86,9 @@ public:
         base_type::tempStart();
     }
 
+    // Can output several lines per input block
+    bool schedulable() { return false; }
+
     int run() {
         int count = base_type::_in->read();
         if (count < 0) { return -1; }
@@ -44,6 +44,9 @@ namespace dab {
             base_type::tempStart();
         }
 
+        // Can output several symbols per input block
+        bool schedulable() { return false; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
@@ -23,7 +23,7 @@ namespace dsp::loop {
 
         inline int process(int count, complex_t* in, complex_t* out) {
             for (int i = 0; i < count; i++) {
-                out[i] = in[i] * math::phasor(-pcl.phase);
+                out[i] = in[i] * math::fastPhasor(-pcl.phase);
                 pcl.advance(errorFunction(out[i]));
             }
             return count;
@@ -38,7 +38,7 @@ namespace dsp::loop {
                 const float PHASE3 = 3.8682349942715186;
                 const float PHASE4 = -0.29067248091319986;
 
-                float phase = val.phase();
+                float phase = math::polyAtan2<math::ATAN2_ACCURACY_HIGH>(val.im, val.re);
                 float dp1 = math::normalizePhase(phase - PHASE1);
                 float dp2 = math::normalizePhase(phase - PHASE2);
                 float dp3 = math::normalizePhase(phase - PHASE3);
@@ -180,6 +180,11 @@ namespace dsp::demod {
             return outCount;
         }
 
+        // Only the clock recovery changes the rate, the stages before it work in place in the output buffer
+        int maxOutputSize(int count) { return std::max<int>(count, recov.maxOutputSize(count)); }
+
+        void mapMetadata(const Metadata& in, Metadata& out) { recov.mapMetadata(in, out); }
+
     protected:
         double _symbolrate;
         double _samplerate;
@@ -20,6 +20,12 @@ enum IFNRPreset {
     IFNR_PRESET_BROADCAST
 };
 
+enum IFNRQuality {
+    IFNR_QUALITY_HIGH,
+    IFNR_QUALITY_NORMAL,
+    IFNR_QUALITY_LOW
+};
+
 namespace demod {
     class Demodulator {
     public:
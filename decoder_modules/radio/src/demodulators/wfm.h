@@ -4,6 +4,7 @@
 #include <dsp/clock_recovery/mm.h>
 #include <dsp/loop/fast_agc.h>
 #include <dsp/loop/costas.h>
+#include <dsp/convert/complex_to_real.h>
 #include <dsp/taps/root_raised_cosine.h>
 #include <dsp/digital/binary_slicer.h>
 #include <dsp/digital/manchester_decoder.h>
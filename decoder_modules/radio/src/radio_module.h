@@ -34,6 +34,14 @@ std::map<IFNRPreset, double> ifnrTaps = {
     { IFNR_PRESET_BROADCAST, 32 }
 };
 
+// Samples between two full searches for the strongest bin, the peak is only followed from bin to bin in between.
+// Normal is the default, High searches at every sample and gives the exact output of the full search.
+std::map<IFNRQuality, int> ifnrHops = {
+    { IFNR_QUALITY_HIGH, 1 },
+    { IFNR_QUALITY_NORMAL, 4 },
+    { IFNR_QUALITY_LOW, 16 }
+};
+
 class RadioModule : public ModuleManager::Instance {
 public:
     RadioModule(std::string name) {
@@ -49,6 +57,10 @@ public:
         ifnrPresets.define("Voice", IFNR_PRESET_VOICE);
         ifnrPresets.define("Narrow Band", IFNR_PRESET_NARROW_BAND);
 
+        ifnrQualities.define("High", IFNR_QUALITY_HIGH);
+        ifnrQualities.define("Normal", IFNR_QUALITY_NORMAL);
+        ifnrQualities.define("Low", IFNR_QUALITY_LOW);
+
         // Initialize the config if it doesn't exist
         bool created = false;
         config.acquire();
@@ -71,13 +83,18 @@ public:
         ifChain.init(vfo->output);
 
         nb.init(NULL, 500.0 / 24000.0, 10.0);
-        fmnr.init(NULL, 32);
+        fmnr.init(NULL, 32, ifnrHops[IFNR_QUALITY_NORMAL]);
         squelch.init(NULL, MIN_SQUELCH);
 
         ifChain.addBlock(&nb, false);
         ifChain.addBlock(&squelch, false);
         ifChain.addBlock(&fmnr, false);
 
+        // Run the chains on a single thread each instead of one thread per block
+        ifChain.setFused(true, [](dsp::stream<dsp::complex_t>* out){});
+        dsp::latency::add(name + " IF", &ifLatency, "VFO " + name);
+        ifChain.setLatencyProbe(&ifLatency);
+
         // Initialize audio DSP chain
         afChain.init(&dummyAudioStream);
 
@@ -86,12 +103,17 @@ public:
 
         afChain.addBlock(&resamp, true);
         afChain.addBlock(&deemp, false);
+        afChain.setFused(true, [](dsp::stream<dsp::stereo_t>* out){});
+        dsp::latency::add(name + " demodulator", &demodLatency, name + " IF");
+        dsp::latency::add(name + " AF", &afLatency, name + " demodulator");
+        afChain.setLatencyProbe(&afLatency);
 
         // Initialize the sink
         srChangeHandler.ctx = this;
         srChangeHandler.handler = sampleRateChangeHandler;
         stream.init(afChain.out, &srChangeHandler, audioSampleRate);
         sigpath::sinkManager.registerStream(name, &stream);
+        dsp::latency::link("Sink stream " + name, name + " AF");
 
         // Select the demodulator
         selectDemodByID((DemodID)selectedDemodID);
@@ -274,6 +296,13 @@ private:
                 }
                 if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
             }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::beginDisabled(); }
+            ImGui::LeftLabel("IF NR Quality");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::Combo(("##_radio_fmifnr_quality_" + _this->name).c_str(), &_this->fmIFQualityId, _this->ifnrQualities.txt)) {
+                _this->setIFNRQuality(_this->ifnrQualities[_this->fmIFQualityId]);
+            }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
         }
 
         // Demodulator specific menu
@@ -352,6 +381,7 @@ private:
         selectedDemod->setInput(ifChain.out);
 
         // Set AF chain's input
+        selectedDemod->getOutput()->latencyProbe = &demodLatency;
         afChain.setInput(selectedDemod->getOutput(), [=](dsp::stream<dsp::stereo_t>* out){ stream.setInput(out); });
 
         // Load config
@@ -368,6 +398,7 @@ private:
         FMIFNRAllowed = selectedDemod->getFMIFNRAllowed();
         FMIFNREnabled = false;
         fmIFPresetId = ifnrPresets.valueId(IFNR_PRESET_VOICE);
+        fmIFQualityId = ifnrQualities.valueId(IFNR_QUALITY_NORMAL);
         nbAllowed = selectedDemod->getNBAllowed();
         nbEnabled = false;
         nbLevel = 0.0f;
@@ -405,6 +436,12 @@ private:
                 fmIFPresetId = ifnrPresets.keyId(presetOpt);
             }
         }
+        if (config.conf[name][selectedDemod->getName()].contains("fmifnrQuality")) {
+            std::string qualityOpt = config.conf[name][selectedDemod->getName()]["fmifnrQuality"];
+            if (ifnrQualities.keyExists(qualityOpt)) {
+                fmIFQualityId = ifnrQualities.keyId(qualityOpt);
+            }
+        }
         if (config.conf[name][selectedDemod->getName()].contains("noiseBlankerEnabled")) {
             nbEnabled = config.conf[name][selectedDemod->getName()]["noiseBlankerEnabled"];
         }
@@ -431,6 +468,7 @@ private:
 
         // Configure FM IF Noise Reduction
         setIFNRPreset((selectedDemodID == RADIO_DEMOD_NFM) ? ifnrPresets[fmIFPresetId] : IFNR_PRESET_BROADCAST);
+        setIFNRQuality(ifnrQualities[fmIFQualityId]);
         setFMIFNREnabled(FMIFNRAllowed ? FMIFNREnabled : false);
 
         // Configure squelch
@@ -579,6 +617,17 @@ private:
         config.release(true);
     }
 
+    void setIFNRQuality(IFNRQuality quality) {
+        fmIFQualityId = ifnrQualities.valueId(quality);
+        if (!selectedDemod) { return; }
+        fmnr.setHop(ifnrHops[quality]);
+
+        // Save config
+        config.acquire();
+        config.conf[name][selectedDemod->getName()]["fmifnrQuality"] = ifnrQualities.key(fmIFQualityId);
+        config.release(true);
+    }
+
     static void vfoUserChangedBandwidthHandler(double newBw, void* ctx) {
         RadioModule* _this = (RadioModule*)ctx;
         _this->setBandwidth(newBw);
@@ -663,10 +712,16 @@ private:
 
     SinkManager::Stream stream;
 
+    // Latency at the output of the IF chain, the demodulator and the AF chain
+    dsp::latency::Probe ifLatency;
+    dsp::latency::Probe demodLatency;
+    dsp::latency::Probe afLatency;
+
     demod::Demodulator* selectedDemod = NULL;
 
     OptionList<std::string, DeemphasisMode> deempModes;
     OptionList<std::string, IFNRPreset> ifnrPresets;
+    OptionList<std::string, IFNRQuality> ifnrQualities;
 
     double audioSampleRate = 48000.0;
     float minBandwidth;
@@ -686,6 +741,7 @@ private:
     bool FMIFNRAllowed;
     bool FMIFNREnabled = false;
     int fmIFPresetId;
+    int fmIFQualityId;
 
     bool notchEnabled = false;
     float notchPos = 0;
@@ -30,6 +30,7 @@ public:
         s2m.init(_stream->sinkOut);
         monoPacker.init(&s2m.out, 512);
         stereoPacker.init(_stream->sinkOut, 512);
+        dsp::latency::add("Audio sink " + _streamName, &latency, "Sink stream " + _streamName);
 
 #if RTAUDIO_VERSION_MAJOR >= 6
         audio.setErrorCallback(&errorCallback);
@@ -195,6 +196,7 @@ private:
         try {
             audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
             stereoPacker.setSampleCount(bufferFrames);
+            outputLatencyNs = (int64_t)audio.getStreamLatency() * 1000000000LL / sampleRate;
             audio.startStream();
             stereoPacker.start();
         }
@@ -233,6 +235,7 @@ private:
         // }
 
         memcpy(outputBuffer, _this->stereoPacker.out.readBuf, nBufferFrames * sizeof(dsp::stereo_t));
+        _this->latency.record(_this->stereoPacker.out.readMeta, _this->outputLatencyNs);
         _this->stereoPacker.out.flush();
         return 0;
     }
@@ -242,6 +245,10 @@ private:
     dsp::buffer::Packer<float> monoPacker;
     dsp::buffer::Packer<dsp::stereo_t> stereoPacker;
 
+    // Counts the latency of the device on top of the time the block reached the callback
+    dsp::latency::Probe latency;
+    int64_t outputLatencyNs = 0;
+
     std::string _streamName;
 
     int srId = 0;
@@ -88,6 +88,7 @@ public:
         selectByName(selectedDevName);
 
         sigpath::sourceManager.registerSource("RTL-SDR", &handler);
+        dsp::overflow::add(name, &stream.overflow);
     }
 
     ~RTLSDRSourceModule() {
@@ -306,6 +307,8 @@ private:
         rtlsdr_set_offset_tuning(_this->openDev, _this->offsetTuning);
 
         _this->asyncCount = (int)roundf(_this->sampleRate / (200 * 512)) * 512;
+        _this->rateCheck.start(rtlsdr_get_sample_rate(_this->openDev));
+        _this->stamper.start(rtlsdr_get_sample_rate(_this->openDev));
 
         _this->workerThread = std::thread(&RTLSDRSourceModule::worker, _this);
 
@@ -339,6 +342,7 @@ private:
             if (i > 1) {
                 flog::warn("RTL-SDR took {0} attempts to tune...", i);
             }
+            _this->stamper.addTag(dsp::TAG_RETUNE, freq);
         }
         _this->freq = freq;
         flog::info("RTLSDRSourceModule '{0}': Tune: {1}!", _this->name, utils::formatFreq(_this->freq));
@@ -431,6 +435,7 @@ private:
             if (SmGui::SliderInt(CONCAT("##_rtlsdr_gain_", _this->name), &_this->gainId, 0, _this->gainList.size() - 1, SmGui::FMT_STR_NONE)) {
                 if (_this->running) {
                     rtlsdr_set_tuner_gain(_this->openDev, _this->getGainById(_this->gainId));
+                    _this->stamper.addTag(dsp::TAG_GAIN_CHANGE, (double)_this->getGainById(_this->gainId) / 10.0);
                 }
                 if (_this->selectedDevName != "") {
                     config.acquire();
@@ -449,6 +454,7 @@ private:
             if (ImGui::SliderInt(CONCAT("##_rtlsdr_gain_", _this->name), &_this->gainId, 0, std::max<int>(0, _this->gainList.size() - 1), dbTxt)) {
                 if (_this->running) {
                     rtlsdr_set_tuner_gain(_this->openDev, _this->getGainById(_this->gainId));
+                    _this->stamper.addTag(dsp::TAG_GAIN_CHANGE, (double)_this->getGainById(_this->gainId) / 10.0);
                 }
                 if (_this->selectedDevName != "") {
                     config.acquire();
@@ -526,6 +532,10 @@ private:
             writeBuf[i].re = (buf[i*2+0] - 128 + 0.5f) / (128.0f - 0.5f);
             writeBuf[i].im = (buf[i*2+1] - 128 + 0.5f) / (128.0f - 0.5f);
         }        
+
+        // The driver drops transfers silently when we don't keep up, catch it from the missing samples
+        _this->rateCheck.update(_this->stream.overflow, sampleCount);
+        _this->stamper.stamp(_this->stream.writeMeta, sampleCount);
         _this->stream.swap(sampleCount);
     }
 
@@ -533,6 +543,8 @@ private:
     rtlsdr_dev_t* openDev;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
+    dsp::overflow::RateCheck rateCheck;
+    dsp::MetadataStamper stamper;
     uint32_t sampleRate;
     SourceManager::SourceHandler handler;
     bool running = false;